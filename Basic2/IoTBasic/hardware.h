@@ -1029,6 +1029,22 @@
 #define SPIRAMSBSIZE 128
 #endif
 
+/* 
+ * The page cache of the SPI RAM, SPIRAMSETS sets of SPIRAMWAYS pages with 
+ * SPIRAMPAGESIZE bytes each. SPIRAMPREFETCH reads the next page of the 
+ * program in the same transaction with a sequential token read.
+ */
+#ifdef ARDUINOSPIRAM
+#define SPIRAMPAGESIZE 32
+#define SPIRAMWAYS 2
+#ifdef ARDUINO_AVR_MEGA2560
+#define SPIRAMSETS 4
+#else
+#define SPIRAMSETS 2
+#endif
+#define SPIRAMPREFETCH
+#endif
+
 
 /*
  * Does the platform has command line args and do we want to use them 
@@ -4028,6 +4028,18 @@ int8_t eread(uint16_t a) {
   return (int8_t) EEPROM.read(a); 
 #endif
 }
+
+/* 
+ * the ESP8266 core keeps the EEPROM in a RAM buffer, it can be read in place,
+ * on ESP32 getDataPtr() would mark the buffer dirty for every commit 
+ */
+int8_t* eaddress() {
+#if defined(ARDUINO_ARCH_ESP8266) && defined(ARDUINOEEPROM)
+  return (int8_t*) EEPROM.getConstDataPtr();
+#else
+  return 0;
+#endif
+}
 #else 
 #if defined(ARDUINOI2CEEPROM)
 uint16_t elength() { 
@@ -4081,11 +4093,15 @@ int8_t eread(uint16_t a) {
  
 #endif
 }
+
+/* the I2C EEPROM is never in memory */
+int8_t* eaddress() { return 0; }
 #else
 /* no EEPROM present */
 uint16_t elength() { return 0; }
 void eupdate(uint16_t a, int8_t c) { return; }
 int8_t eread(uint16_t a) { return 0; }
+int8_t* eaddress() { return 0; }
 #endif
 #endif
 
@@ -6060,13 +6076,15 @@ void detachinterrupt(uint8_t pin) {  };
  * 64kB SRAM
  * The code below is taken in part from the SRAMsimple library
  * 
- * two buffers are implemented: 
- * - a ro buffer used by memread, this buffer is mainly reading the token 
- *  stream at runtime. 
- * - a rw buffer used by memread2 and memwrite2, this buffer is mainly accessing
+ * a set associative write back page cache is implemented: 
+ * - the ro calls are used by memread, mainly reading the token stream 
+ *  at runtime. A miss on the page after the last one prefetches the 
+ *  next page in the same transaction.
+ * - the rw calls are used by memread2 and memwrite2, mainly accessing
  *  the heap at runtime. In interactive mode this is also the interface to read 
  *  and write program code to memory 
  * 
+ * The Posix simulator runs the same cache and counts the transactions.
  */
 
 #ifdef ARDUINOSPIRAM
@@ -6087,8 +6105,25 @@ void detachinterrupt(uint8_t pin) {  };
 #define SPIRAMSEQ   0x40
 #define SPIRAMBYTE  0x00
 
-/* the RAM begin method sets the RAM to sequential mode */
+/* the page cache, see below */
+#define SPIRAMLINES (SPIRAMSETS * SPIRAMWAYS)
+int8_t spiram_cache[SPIRAMLINES][SPIRAMPAGESIZE];
+uint16_t spiram_cachepage[SPIRAMLINES];
+uint8_t spiram_cacheage[SPIRAMLINES];
+uint8_t spiram_cacheflags[SPIRAMLINES]; /* 1 is valid, 2 is dirty */
+uint8_t spiram_lastline = 0;
+uint16_t spiram_ropage = 0xffff;
+
+int8_t spiram_find(uint16_t);
+
+/* the RAM begin method sets the RAM to sequential mode and clears the cache */
 uint16_t spirambegin() {
+  uint8_t i;
+
+  for (i = 0; i < SPIRAMLINES; i++) {
+    spiram_cacheflags[i] = 0;
+    spiram_cacheage[i] = i % SPIRAMWAYS;
+  }
   pinMode(RAMPIN, OUTPUT);
   digitalWrite(RAMPIN, LOW);
   SPI.transfer(SPIRAMRSTIO);
@@ -6099,9 +6134,12 @@ uint16_t spirambegin() {
   return 65535;
 }
 
-/* the simple unbuffered byte read, with a cast to signed 8 bit integer */
+/* the simple unbuffered byte read, a dirty cached page is newer than the chip */
 int8_t spiramrawread(uint16_t a) {
   uint8_t c;
+  int8_t l = spiram_find(a / SPIRAMPAGESIZE);
+
+  if (l >= 0) return spiram_cache[l][a % SPIRAMPAGESIZE];
   digitalWrite(RAMPIN, LOW);
   SPI.transfer(SPIRAMREAD);
   SPI.transfer((uint8_t)(a >> 8));
@@ -6111,26 +6149,7 @@ int8_t spiramrawread(uint16_t a) {
   return c;
 }
 
-/* one read only buffer for access from the token stream 
-    memread calls this */
-uint16_t spiram_robufferaddr = 0;
-uint8_t spiram_robuffervalid=0;
-const uint8_t spiram_robuffersize = 32;
-int8_t spiram_robuffer[spiram_robuffersize];
-
-/* one rw buffer for access to the heap and all the program editing 
-    memread2 and memwrite2 call this*/
-uint16_t spiram_rwbufferaddr = 0;
-uint8_t spiram_rwbuffervalid=0;
-const uint8_t spiram_rwbuffersize = 32; /* also change the addressmask if you want to play here */
-int8_t spiram_rwbuffer[spiram_rwbuffersize];
-uint8_t spiram_rwbufferclean = 1; 
-
-const uint16_t spiram_addrmask=0xffe0;
-/* const address_t spiram_addrmask=0xffd0; // 64 byte frame */
-
-/* the elementary buffer access functions used almost everywhere */
-
+/* the elementary buffer access functions, l bytes in one transaction */
 void spiram_bufferread(uint16_t a, int8_t* b, uint16_t l) {
   digitalWrite(RAMPIN, LOW);
   SPI.transfer(SPIRAMREAD);
@@ -6140,86 +6159,153 @@ void spiram_bufferread(uint16_t a, int8_t* b, uint16_t l) {
   digitalWrite(RAMPIN, HIGH);
 } 
 
+/* the buffer transfer would overwrite b with the received bytes, hence bytewise */
 void spiram_bufferwrite(uint16_t a, int8_t* b, uint16_t l) {
   digitalWrite(RAMPIN, LOW); 
   SPI.transfer(SPIRAMWRITE);
   SPI.transfer((uint8_t)(a >> 8));
   SPI.transfer((uint8_t)a);
-  SPI.transfer(b, l);
+  while (l--) SPI.transfer((uint8_t) *b++);
   digitalWrite(RAMPIN, HIGH);
 }
 
-int8_t spiram_robufferread(uint16_t a) {
-/* we address a byte known to the rw buffer, then get it from there */
-  if (spiram_rwbuffervalid && ((a & spiram_addrmask) == spiram_rwbufferaddr)) {
-    return spiram_rwbuffer[a-spiram_rwbufferaddr];
+/* read two pages in one sequential transaction, the second is the prefetch */
+void spiram_pagesread(uint16_t a, int8_t* b1, int8_t* b2) {
+  digitalWrite(RAMPIN, LOW);
+  SPI.transfer(SPIRAMREAD);
+  SPI.transfer((uint8_t)(a >> 8));
+  SPI.transfer((uint8_t)a);
+  SPI.transfer(b1, SPIRAMPAGESIZE);
+  SPI.transfer(b2, SPIRAMPAGESIZE);
+  digitalWrite(RAMPIN, HIGH);
+}
+
+/* 
+ * the page cache, a line is a page, the lines of a set are consecutive,
+ * a page p can only be in set p % SPIRAMSETS. The least recently used 
+ * line of a set is replaced and written back if it is dirty. 
+ */
+
+/* find the line of a page, -1 if it is not cached */
+int8_t spiram_find(uint16_t p) {
+  uint8_t i, s = (p % SPIRAMSETS) * SPIRAMWAYS;
+
+  for (i = s; i < s + SPIRAMWAYS; i++) 
+    if ((spiram_cacheflags[i] & 1) && spiram_cachepage[i] == p) return i;
+  return -1;
+}
+
+/* make a line the most recently used of its set */
+void spiram_touch(uint8_t l) {
+  uint8_t i, s = l - l % SPIRAMWAYS;
+
+  for (i = s; i < s + SPIRAMWAYS; i++) 
+    if (spiram_cacheage[i] < spiram_cacheage[l]) spiram_cacheage[i]++;
+  spiram_cacheage[l] = 0;
+  spiram_lastline = l;
+}
+
+/* free a line for page p, an empty one or the least recently used */
+uint8_t spiram_victim(uint16_t p) {
+  uint8_t i, l, s = (p % SPIRAMSETS) * SPIRAMWAYS;
+
+  l = s;
+  for (i = s; i < s + SPIRAMWAYS; i++) {
+    if (!(spiram_cacheflags[i] & 1)) { l = i; break; }
+    if (spiram_cacheage[i] > spiram_cacheage[l]) l = i;
   }
-  
-/* page fault, we dont have the byte in the ro buffer, so read from the chip*/
-  if (!spiram_robuffervalid || a >= spiram_robufferaddr + spiram_robuffersize || a < spiram_robufferaddr ) {
-      spiram_bufferread(a, spiram_robuffer, spiram_robuffersize);
-      spiram_robufferaddr=a;
-      spiram_robuffervalid=1;
+  if (spiram_cacheflags[l] & 2) 
+    spiram_bufferwrite(spiram_cachepage[l] * SPIRAMPAGESIZE, spiram_cache[l], SPIRAMPAGESIZE);
+  spiram_cacheflags[l] = 0;
+  return l;
+}
+
+/* 
+ * load page p into the cache, with prefetch the next page comes 
+ * with it in the same transaction if it is not yet cached 
+ */
+uint8_t spiram_load(uint16_t p, uint8_t prefetch) {
+  uint8_t l;
+#ifdef SPIRAMPREFETCH
+  uint8_t m;
+#endif
+
+  l = spiram_victim(p);
+  spiram_cachepage[l] = p;
+  spiram_cacheflags[l] = 1;
+  spiram_touch(l);
+#ifdef SPIRAMPREFETCH
+  if (prefetch && SPIRAMLINES > 1 && p + 1 < 65536 / SPIRAMPAGESIZE && spiram_find(p + 1) < 0) {
+    m = spiram_victim(p + 1);
+    spiram_pagesread(p * SPIRAMPAGESIZE, spiram_cache[l], spiram_cache[m]);
+    spiram_cachepage[m] = p + 1;
+    spiram_cacheflags[m] = 1;
+    spiram_touch(m);
+    spiram_touch(l);
+    return l;
   }
-  return spiram_robuffer[a-spiram_robufferaddr];
+#endif
+  spiram_bufferread(p * SPIRAMPAGESIZE, spiram_cache[l], SPIRAMPAGESIZE);
+  return l;
+}
+
+/* the line of an address, loaded if needed */
+uint8_t spiram_line(uint16_t a, uint8_t prefetch) {
+  uint16_t p = a / SPIRAMPAGESIZE;
+  int8_t l;
+
+  if ((spiram_cacheflags[spiram_lastline] & 1) && spiram_cachepage[spiram_lastline] == p) 
+    return spiram_lastline;
+  if ((l = spiram_find(p)) < 0) return spiram_load(p, prefetch);
+  spiram_touch(l);
+  return l;
 }
 
-/* flush the buffer */
+/* the token stream of memread, prefetches if it moves to the next page */
+int8_t spiram_robufferread(uint16_t a) {
+  uint16_t p = a / SPIRAMPAGESIZE;
+  uint8_t l = spiram_line(a, p == spiram_ropage + 1);
+
+  spiram_ropage = p;
+  return spiram_cache[l][a % SPIRAMPAGESIZE];
+}
+
+/* write all dirty pages back to the chip */
 void spiram_rwbufferflush() {
-  if (!spiram_rwbufferclean) {
-    spiram_bufferwrite(spiram_rwbufferaddr, spiram_rwbuffer, spiram_rwbuffersize);
-    spiram_rwbufferclean=1;
-   }
+  uint8_t i;
+
+  for (i = 0; i < SPIRAMLINES; i++) {
+    if (spiram_cacheflags[i] & 2) {
+      spiram_bufferwrite(spiram_cachepage[i] * SPIRAMPAGESIZE, spiram_cache[i], SPIRAMPAGESIZE);
+      spiram_cacheflags[i] &= 1;
+    }
+  }
 }
 
+/* the heap and the program editor, memread2 and memwrite2 call this */
 int8_t spiram_rwbufferread(uint16_t a) {
-/* page fault, do read, ignore the ro buffer buffer */
-  uint16_t p=a & spiram_addrmask;
-  if (!spiram_rwbuffervalid || (p != spiram_rwbufferaddr)) {
-/* flush the buffer if needed */
-    spiram_rwbufferflush();
-/* and reload it */
-    spiram_bufferread(p, spiram_rwbuffer, spiram_rwbuffersize);
-    spiram_rwbufferaddr=p; /* we only handle full pages here */
-    spiram_rwbuffervalid=1;
-  }
-  return spiram_rwbuffer[a-spiram_rwbufferaddr];
+  return spiram_cache[spiram_line(a, 0)][a % SPIRAMPAGESIZE];
 }
 
-/* the buffered file write */
 void spiram_rwbufferwrite(uint16_t a, int8_t c) {
-  uint16_t p=a&spiram_addrmask;
-/* correct the two buffers if needed */
-  if (spiram_robuffervalid && a >= spiram_robufferaddr && a < spiram_robufferaddr + spiram_robuffersize) {
-    spiram_robuffer[a-spiram_robufferaddr]=c;
-  }
-/* if we have the frame, write it, mark the buffer dirty and return */
-  if (spiram_rwbuffervalid && p == spiram_rwbufferaddr) {
-    spiram_rwbuffer[a-spiram_rwbufferaddr]=c;
-    spiram_rwbufferclean=0;
-    return;
-  }
-/* if we end up here the write was impossible because we dont have the frame, so flush and then get it */
-  spiram_rwbufferflush();
-  (void) spiram_rwbufferread(a);
-  spiram_rwbuffer[a-spiram_rwbufferaddr]=c;
-  spiram_rwbufferclean=0;
+  uint8_t l = spiram_line(a, 0);
+
+  spiram_cache[l][a % SPIRAMPAGESIZE] = c;
+  spiram_cacheflags[l] |= 2;
 }
 
 /* the simple unbuffered byte write, with a cast to signed char */
 void spiramrawwrite(uint16_t a, int8_t c) {
+  int8_t l = spiram_find(a / SPIRAMPAGESIZE);
+
   digitalWrite(RAMPIN, LOW);
   SPI.transfer(SPIRAMWRITE);
   SPI.transfer((uint8_t)(a >> 8));
   SPI.transfer((uint8_t)a);
   SPI.transfer((uint8_t) c);
   digitalWrite(RAMPIN, HIGH);
-/* also refresh the ro buffer if in the frame */
-  if (a >= spiram_robufferaddr && a < spiram_robufferaddr + spiram_robuffersize && spiram_robufferaddr > 0) 
-    spiram_robuffer[a-spiram_robufferaddr]=c;
-/* and the rw buffer if needed) */
-  if (a >= spiram_rwbufferaddr && a < spiram_rwbufferaddr + spiram_rwbuffersize && spiram_rwbufferaddr > 0) 
-    spiram_rwbuffer[a-spiram_rwbufferaddr]=c;
+/* also refresh the cached page */
+  if (l >= 0) spiram_cache[l][a % SPIRAMPAGESIZE] = c;
 }
 #endif
 
@@ -335,6 +335,8 @@ int  avgfastticker();
  * elength() returns the length of the EEPROM.
  * eupdate() updates one EEPROM cell with a value. Does not flush. 
  * eread() reads one EEPROM cell.
+ * eaddress() is the EEPROM in memory if it can be read directly, 0 if not.
+ *    Programs stored there are run in place.
  */ 
 
 void ebegin(); 
@@ -342,6 +344,7 @@ void eflush();
 uint16_t elength();
 void eupdate(uint16_t, int8_t);
 int8_t eread(uint16_t);
+int8_t* eaddress();
 
 /* 
  *  The wrappers of the arduino io functions.
@@ -1192,13 +1195,14 @@ int camerafbget(int);
  * Currently only the 23LCV512 is implemented, assuming a 64kB SRAM.
  * Part of code is taken in part from the SRAMsimple library.
  * 
- * Two buffers are implemented: 
+ * A set associative write back page cache is implemented: 
  * 
- * - a ro buffer used by memread, this buffer is mainly reading the token 
- *  stream at runtime. 
- * - a rw buffer used by memread2 and memwrite2, this buffer is mainly accessing
- *  the heap at runtime. In interactive mode this is also the interface to read 
+ * - the ro calls are used by memread, mainly reading the token stream at 
+ *  runtime. A miss on the page after the last one prefetches the next page.
+ * - the rw calls are used by memread2 and memwrite2, mainly accessing the 
+ *  heap at runtime. In interactive mode this is also the interface to read 
  *  and write program code to memory. 
+ * - spiram_rwbufferflush() writes all dirty pages back.
  * 
  */
 
@@ -46,6 +46,82 @@
 #include "setjmp.h"
 #endif
 
+/* the maths functions follow the type of the long double numbers */
+#ifdef HASLONGDOUBLE
+#include <tgmath.h>
+#endif
+
+/* 
+ * SIMD for MAT on float and double numbers, AVX or SSE2 on x86 and NEON 
+ * on 64 bit ARM, INT needs SSE4.1 on x86, without these MAT is scalar
+ */
+#if defined(HASARRAYMATH) && defined(HASFLOAT) && !defined(HASLONGDOUBLE)
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#define HASMATSIMD
+#if defined(__AVX__) && defined(HAS64BIT)
+typedef __m256d simd_t;
+#define SIMDLOAD(p) _mm256_loadu_pd(p)
+#define SIMDSTORE(p, x) _mm256_storeu_pd(p, x)
+#define SIMDSQRT(x) _mm256_sqrt_pd(x)
+#define SIMDABS(x) _mm256_andnot_pd(_mm256_set1_pd(-0.0), x)
+#define SIMDFLOOR(x) _mm256_floor_pd(x)
+#elif defined(__AVX__)
+typedef __m256 simd_t;
+#define SIMDLOAD(p) _mm256_loadu_ps(p)
+#define SIMDSTORE(p, x) _mm256_storeu_ps(p, x)
+#define SIMDSQRT(x) _mm256_sqrt_ps(x)
+#define SIMDABS(x) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x)
+#define SIMDFLOOR(x) _mm256_floor_ps(x)
+#elif defined(HAS64BIT)
+typedef __m128d simd_t;
+#define SIMDLOAD(p) _mm_loadu_pd(p)
+#define SIMDSTORE(p, x) _mm_storeu_pd(p, x)
+#define SIMDSQRT(x) _mm_sqrt_pd(x)
+#define SIMDABS(x) _mm_andnot_pd(_mm_set1_pd(-0.0), x)
+#ifdef __SSE4_1__
+#define SIMDFLOOR(x) _mm_floor_pd(x)
+#endif
+#else
+typedef __m128 simd_t;
+#define SIMDLOAD(p) _mm_loadu_ps(p)
+#define SIMDSTORE(p, x) _mm_storeu_ps(p, x)
+#define SIMDSQRT(x) _mm_sqrt_ps(x)
+#define SIMDABS(x) _mm_andnot_ps(_mm_set1_ps(-0.0f), x)
+#ifdef __SSE4_1__
+#define SIMDFLOOR(x) _mm_floor_ps(x)
+#endif
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HASMATSIMD
+#ifdef HAS64BIT
+typedef float64x2_t simd_t;
+#define SIMDLOAD(p) vld1q_f64(p)
+#define SIMDSTORE(p, x) vst1q_f64(p, x)
+#define SIMDSQRT(x) vsqrtq_f64(x)
+#define SIMDABS(x) vabsq_f64(x)
+#define SIMDFLOOR(x) vrndmq_f64(x)
+#else
+typedef float32x4_t simd_t;
+#define SIMDLOAD(p) vld1q_f32(p)
+#define SIMDSTORE(p, x) vst1q_f32(p, x)
+#define SIMDSQRT(x) vsqrtq_f32(x)
+#define SIMDABS(x) vabsq_f32(x)
+#define SIMDFLOOR(x) vrndmq_f32(x)
+#endif
+#endif
+#endif
+
+/* the mixed integer mode needs a long double that holds every int64 */
+#ifdef HASINT64
+#if LDBL_MANT_DIG < 64
+#error "HASINT64 needs a long double with a 64 bit mantissa"
+#endif
+#define INT64MAX 9223372036854775807LL
+#define INT64MIN (-INT64MAX - 1)
+#endif
+
 /* Global BASIC definitions */
 
 /*
@@ -238,6 +314,15 @@ const char sbit[]		PROGMEM = "BIT";
 #ifdef HASCAMERA
 const char scam[]	PROGMEM = "CAM";
 #endif
+#ifdef HASPROFILER
+const char sprofile[]	PROGMEM = "PROFILE";
+#endif
+#ifdef HASMULTILINEFUNCTIONS
+const char slocal[]	PROGMEM = "LOCAL";
+#endif
+#ifdef HASARRAYMATH
+const char smat[]	PROGMEM = "MAT";
+#endif
 
 
 /* zero terminated keyword storage */
@@ -323,6 +408,15 @@ const char* const keyword[] PROGMEM = {
   sshl, sshr, sbit,
 #ifdef HASCAMERA
   scam,
+#endif
+#ifdef HASPROFILER
+  sprofile,
+#endif
+#ifdef HASMULTILINEFUNCTIONS
+  slocal,
+#endif
+#ifdef HASARRAYMATH
+  smat,
 #endif
   0
 };
@@ -407,6 +501,15 @@ const token_t tokens[] PROGMEM = {
   TSHL, TSHR, TBIT,
 #ifdef HASCAMERA
   TCAM,
+#endif
+#ifdef HASPROFILER
+  TPROFILE,
+#endif
+#ifdef HASMULTILINEFUNCTIONS
+  TLOCAL,
+#endif
+#ifdef HASARRAYMATH
+  TMAT,
 #endif
   0
 };
@@ -494,7 +597,9 @@ const int messagesize = sizeof(message) / sizeof(char*);
   		stringlength type. Currently only 1 byte and 2 bytes are tested.
 */
 #ifdef HASFLOAT
-#ifdef HAS64BIT 
+#ifdef HASLONGDOUBLE
+const number_t maxnum = 9223372036854775807LL;
+#elif defined(HAS64BIT)
 const number_t maxnum = 9007199254740992;
 #else   
 const number_t maxnum = 16777216;
@@ -515,134 +620,170 @@ const address_t maxaddr = (address_t)(~0);
 */
 
 /* the stack, all BASIC arithmetic is done here */
-accu_t stack[STACKSIZE];
-address_t sp = 0;
+BSTATE accu_t stack[STACKSIZE];
+BSTATE address_t sp = 0;
 
 /* a small buffer to process string arguments, mostly used for Arduino PROGMEM and string functions */
 /* use with care as it is used in some string functions */
-char sbuffer[SBUFSIZE];
+BSTATE char sbuffer[SBUFSIZE];
 
 /* the input buffer, the lexer can tokenize this and run from it, bi is an index to this.
    bi must be global as it is the program cursor in interactive mode */
-char ibuffer[BUFSIZE] = "\0";
-char *bi;
+BSTATE char ibuffer[BUFSIZE] = "\0";
+BSTATE char *bi;
 
 /* a static array of variables A-Z for the small systems that have no heap */
 #ifndef HASAPPLE1
-number_t vars[VARSIZE];
+BSTATE number_t vars[VARSIZE];
 #endif
 
 /* the BASIC working memory, either malloced or allocated as a global array */
 #if (defined(MEMSIZE) && MEMSIZE != 0)
-mem_t mem[MEMSIZE];
+BSTATE mem_t mem[MEMSIZE];
 #else
-mem_t* mem;
+BSTATE mem_t* mem;
+#endif
+BSTATE address_t himem, memsize;
+#ifdef HASSTRINGHEAP
+BSTATE address_t strhimem; /* the last byte of the string heap, objects start above */
 #endif
-address_t himem, memsize;
 
 /* reimplementation of the loops, will replace the forstack */
-bloop_t loopstack[FORDEPTH];
-index_t loopsp = 0;
+BSTATE bloop_t loopstack[FORDEPTH];
+BSTATE index_t loopsp = 0;
 
 /* the GOSUB stack remembers an address to jump to */
-address_t gosubstack[GOSUBDEPTH];
-index_t gosubsp = 0;
+BSTATE address_t gosubstack[GOSUBDEPTH];
+BSTATE index_t gosubsp = 0;
 
 /* arithmetic accumulators */
-number_t x, y;
+BSTATE number_t x, y;
 
 /* the name of on object, replaced xc and xy in BASIC 1 */
-name_t name;
+BSTATE name_t name;
 
 /* an address accumulator, used a lot in string operations */
-address_t ax;
+BSTATE address_t ax;
 
 /* a string index registers, new style identifying a string either in C memory or BASIC memory */
-string_t sr;
+BSTATE string_t sr;
 
 /* the active token */
-token_t token;
+BSTATE token_t token;
 
 /* the curent error, can be a token, hence token type */
-token_t er;
+BSTATE token_t er;
 /* the jmp buffer for the error handling */
 #if USELONGJUMP == 1
-jmp_buf sthook;
+BSTATE jmp_buf sthook;
 #endif
 
 /* a trapable error */
-mem_t ert;
+BSTATE mem_t ert;
 
 /* the interpreter state, interactive, run or run from EEPROM */
-mem_t st;
+BSTATE mem_t st;
 
 /* the current program location */
-address_t here;
+BSTATE address_t here;
 
 /* the topmost byte of a program in memory, beginning of free BASIC RAM */
-address_t top;
+BSTATE address_t top;
 
 /* used to format output with # */
-mem_t form = 0;
+BSTATE mem_t form = 0;
 
 /* do we use the Microsoft convention of an array starting at 0 or 1 like Apple 1
 	two seperate variables because arraylimit can be changed at runtime for existing arrays
 	msarraylimit says if an array should be created with n or n+1 elements */
 #ifdef MSARRAYLIMITS
-mem_t msarraylimits = 1;
-address_t arraylimit = 0;
+BSTATE mem_t msarraylimits = 1;
+BSTATE address_t arraylimit = 0;
 #else
-mem_t msarraylimits = 0;
-address_t arraylimit = 1;
+BSTATE mem_t msarraylimits = 0;
+BSTATE address_t arraylimit = 1;
 #endif
 
 /* behaviour around boolean, needed to change the interpreters personality at runtime */
 /* -1 is microsoft true while 1 is Apple 1 and C style true. */
-mem_t booleanmode = BOOLEANMODE;
+BSTATE mem_t booleanmode = BOOLEANMODE;
 
 /* setting the interpreter to integer at runtime */
-mem_t forceint = 0;
+BSTATE mem_t forceint = 0;
 
 /* the default size of a string now as a variable */
-stringlength_t defaultstrdim = STRSIZEDEF;
+BSTATE stringlength_t defaultstrdim = STRSIZEDEF;
 
 /* the base of the random number generator
  	0 is Apple 1 style RND from 0 to n-epsilon
  	1 is Palo Alto style from 1 to n
 */
-mem_t randombase = 0;
+BSTATE mem_t randombase = 0;
 
 /* is substring logic used or not */
 #ifdef SUPPRESSSUBSTRINGS
-mem_t substringmode = 0;
+BSTATE mem_t substringmode = 0;
 #else
-mem_t substringmode = 1;
+BSTATE mem_t substringmode = 1;
 #endif
 
 /* the flag for true MS tabs */
-mem_t reltab = 0;
+BSTATE mem_t reltab = 0;
 mem_t dummy;
 
 /* the flag for lower case names */
-mem_t lowercasenames = 0;
+BSTATE mem_t lowercasenames = 0;
 
 /* the number of arguments parsed from a command */
-mem_t args;
+BSTATE mem_t args;
 
 /* the random number seed, this is unsigned */
 #ifndef HASFLOAT
-address_t rd;
+BSTATE address_t rd;
 #else
-unsigned long rd;
+BSTATE unsigned long rd;
+
+/* the state of the xoshiro128** random number streams, the current stream and the last seed */
+BSTATE uint32_t rndstate[RNDSTREAMS][4];
+BSTATE mem_t rndstream = 0;
+BSTATE unsigned long rndseedvalue = 0;
+#endif
+
+/* the record size of the random access file and the bytes of the current record */
+#ifdef HASRECORDIO
+BSTATE address_t recordsize = 1;
+BSTATE address_t recordbytes = 0;
 #endif
 
 /* the RUN debuglevel */
-mem_t debuglevel = 0;
+BSTATE mem_t debuglevel = 0;
 
 /* DATA pointer, where is the current READ statement  */
 #ifdef HASDARTMOUTH
-address_t data = 0;
-address_t datarc = 1;
+BSTATE address_t data = 0;
+BSTATE address_t datarc = 1;
+#endif
+
+/* the index of all DATA items, the state is 0 for not built, 1 for built and -1 for not possible */
+#ifdef HASDATAINDEX
+BSTATE address_t dataindex[DATAINDEXSIZE];
+BSTATE address_t ndata = 0;
+BSTATE mem_t dataindexstate = 0;
+#endif
+
+/* the name pool of the interned long names and the lexer buffer for names */
+#ifdef HASNAMEIDS
+BSTATE mem_t namepool[NAMEPOOLSIZE];
+BSTATE address_t namepooltop = 0;
+BSTATE mem_t lexname[MAXNAME];
+#endif
+
+/* the call frames of FN and the last function found */
+#ifdef HASDARTMOUTH
+BSTATE fnframe_t fnframes[FNLIMIT];
+BSTATE int fnframesp = 0;
+BSTATE number_t fnslots[FNSLOTS];
+BSTATE heap_t fncache;
 #endif
 
 /*
@@ -653,14 +794,14 @@ address_t datarc = 1;
 #ifdef HASARGS
 int bargc;
 char** bargv;
-mem_t bnointafterrun = 0;
+BSTATE mem_t bnointafterrun = 0;
 #endif
 
 /* formaters lastouttoken and spaceafterkeyword to make a nice LIST */
-mem_t lastouttoken;
-mem_t spaceafterkeyword;
-mem_t outliteral = 0;
-mem_t lexliteral = 0;
+BSTATE mem_t lastouttoken;
+BSTATE mem_t spaceafterkeyword;
+BSTATE mem_t outliteral = 0;
+BSTATE mem_t lexliteral = 0;
 
 /*
    The cache for the heap search - helps the string code.
@@ -670,20 +811,20 @@ mem_t lexliteral = 0;
    last found object.
 */
 #ifdef HASAPPLE1
-heap_t bfind_object;
+BSTATE heap_t bfind_object;
 #endif
 
 /*
    a variable for string to numerical conversion,
    telling you were the number ended.
 */
-address_t vlength;
+BSTATE address_t vlength;
 
 /* the timer code - very simple needs to be converted to to a struct */
 /* timer type */
 #ifdef HASTIMER
-btimer_t after_timer = {0, 0, 0, 0, 0};
-btimer_t every_timer = {0, 0, 0, 0, 0};
+BSTATE btimer_t after_timer = {0, 0, 0, 0, 0};
+BSTATE btimer_t every_timer = {0, 0, 0, 0, 0};
 #endif
 
 /* the event code */
@@ -693,13 +834,13 @@ btimer_t every_timer = {0, 0, 0, 0, 0};
 #define EVENTLISTSIZE 4
 
 /* the event list, nevents is the number of active events */
-mem_t nevents = 0;
-int ievent = 0;
-mem_t events_enabled = 1;
-volatile bevent_t eventlist[EVENTLISTSIZE];
+BSTATE mem_t nevents = 0;
+BSTATE int ievent = 0;
+BSTATE mem_t events_enabled = 1;
+BSTATE volatile bevent_t eventlist[EVENTLISTSIZE];
 
 /* the extension of the GOSUB stack */
-mem_t gosubarg[GOSUBDEPTH];
+BSTATE mem_t gosubarg[GOSUBDEPTH];
 #endif
 
 #ifdef HASERRORHANDLING
@@ -709,32 +850,39 @@ typedef struct {
   address_t linenumber;
 } berrorh_t;
 
-berrorh_t berrorh = {0 , 0};
-mem_t erh = 0;
+BSTATE berrorh_t berrorh = {0 , 0};
+BSTATE mem_t erh = 0;
 #endif
 
 /* the string for real time clocks */
-char rtcstring[20] = { 0 };
+BSTATE char rtcstring[20] = { 0 };
 
 /* the units pulse operates on, in microseconds*/
-address_t bpulseunit = 10;
+BSTATE address_t bpulseunit = 10;
 
 /* only needed if the break condition is handled in the background */
-char breakcondition = 0;
+BSTATE char breakcondition = 0;
 
 /* the FN context, how deep are we in a nested function call, negative values reserved */
-int fncontext = 0;
+BSTATE int fncontext = 0;
 
 /* the accuracy of a equal or not equal statement on numbers */
 #ifdef HASFLOAT
-number_t epsilon = 0;
+BSTATE number_t epsilon = 0;
 #else
 const number_t epsilon = 0;
 #endif
 
 /* the number of digits displayed in the fraction of a float */
 #ifdef HASFLOAT
-mem_t precision = 5;
+BSTATE mem_t precision = 5;
+#endif
+
+/* the statements a context may run before it yields, 0 is no limit */
+#ifdef HASCONTEXTS
+BSTATE unsigned long bcontextbudget = 0;
+BSTATE unsigned long bcontextcount = 0;
+BSTATE mem_t bcontextyield = 0;
 #endif
 
 /*
@@ -843,6 +991,14 @@ void esave() {
     }
     eupdate(a++, 0);
 
+    /* the program is useless without its names */
+#ifdef HASNAMEIDS
+    if (esavenames(a) == 0) {
+      error(EOUTOFMEMORY);
+      er = 0;
+    }
+#endif
+
     /* needed on I2C EEPROM and other platforms where we buffer */
     eflush();
 
@@ -871,6 +1027,9 @@ void eload() {
       memwrite2(a - eheadersize, beread(a));
       a++;
     }
+#ifdef HASNAMEIDS
+    eloadnames(a + 1);
+#endif
   } else {
     /* no valid program data is stored */
     error(EEEPROM);
@@ -878,12 +1037,44 @@ void eload() {
 #endif
 }
 
+/* 
+ * the name pool is stored after the program, first its length then the names,
+ * both return the address after the pool or 0 if there is no valid pool 
+ */
+#ifdef HASNAMEIDS
+address_t esavenames(address_t a) {
+  address_t i;
+
+  if (a + addrsize + namepooltop > elength()) return 0;
+  setaddress(a, beupdate, namepooltop);
+  a += addrsize;
+  for (i = 0; i < namepooltop; i++) eupdate(a++, namepool[i]);
+  return a;
+}
+
+address_t eloadnames(address_t a) {
+  address_t i, l;
+
+  clrnames();
+  if (a + addrsize > elength()) return 0;
+  l = getaddress(a, beread);
+  a += addrsize;
+  if (l > NAMEPOOLSIZE || a + l > elength()) return 0;
+  for (i = 0; i < l; i++) namepool[i] = eread(a++);
+  namepooltop = l;
+  return a;
+}
+#endif
+
 /* autorun something from EEPROM or a filesystem */
 char autorun() {
 
   /* autorun from EEPROM if there is an EEPROM flagged for autorun */
   if (elength() > 0 && eread(0) == 1) { /* autorun from the EEPROM */
     top = getaddress(1, beread);
+#ifdef HASNAMEIDS
+    eloadnames(top + eheadersize + 1);
+#endif
     st = SERUN;
     return 1; /* EEPROM autorun overrules filesystem autorun */
   }
@@ -931,7 +1122,11 @@ char autorun() {
 address_t bmalloc(name_t* name, address_t l) {
   address_t payloadsize;     /* the payload size */
   address_t heapheadersize = sizeof(name_t) + addrsize; /* this is only used to estimate the free space, it is the maximum */
+#ifndef HASSTRINGHEAP
   address_t b = himem; /* the current position on the heap, we store it in case of errors */
+#else
+  address_t b = strhimem; /* objects are stored above the string heap */
+#endif
 
   /* Initial DEBUG message. */
   if (DEBUG) {
@@ -959,9 +1154,9 @@ address_t bmalloc(name_t* name, address_t l) {
       break;
 #endif
 #ifdef HASDARTMOUTH
-    case TFN: /* the jump address, the type of function/type of return value, the number of vars
-			and all variables are stored*/
-      payloadsize = addrsize + 2 + sizeof(name_t) * l;
+    case TFN: /* the jump address, the type of function/type of return value, the number of 
+			parameters and locals, then l bytes for their bind table and names */
+      payloadsize = addrsize + 3 + l;
       break;
 #endif
     /* these are plain buffers allocated by the MALLOC call in BASIC */
@@ -982,6 +1177,11 @@ address_t bmalloc(name_t* name, address_t l) {
   }
 #endif
 
+  /* the string heap moves down by the size of the object */
+#ifdef HASSTRINGHEAP
+  strshift(payloadsize + (name->token != VARIABLE ? addrsize : 0) + heapnamesize(name) + 1);
+#endif
+
   /* first we reserve space for the payload, address points to the first byte of the payload */
   /* b points to the first free byte after the payload*/
   b -= payloadsize;
@@ -1015,7 +1215,11 @@ address_t bmalloc(name_t* name, address_t l) {
   bfind_object.size = payloadsize;
 
   /* himem is the next free byte now again */
+#ifndef HASSTRINGHEAP
   himem = b;
+#else
+  strhimem = b;
+#endif
 
   if (DEBUG) {
     outsc("** bmalloc returns "); outnumber(bfind_object.address);
@@ -1038,7 +1242,11 @@ address_t bfind(name_t* name) {
   }
 
   /* do we have anything on the heap? */
+#ifndef HASSTRINGHEAP
   if (himem == memsize) return 0; else b = himem + 1;
+#else
+  if (strhimem == memsize) return 0; else b = strhimem + 1;
+#endif
 
   /* we have the object already in cache and return */
   if (name->token == bfind_object.name.token && cmpname(name, &bfind_object.name)) {
@@ -1107,7 +1315,9 @@ address_t bfind(name_t* name) {
 /* reimplementation bfree with name interface */
 address_t bfree(name_t* name) {
   address_t b;
+#ifndef HASSTRINGHEAP
   address_t i;
+#endif
 
   if (DEBUG) {
     outsc("*** bfree called for ");
@@ -1130,10 +1340,15 @@ address_t bfree(name_t* name) {
   }
 
   /* clear the entire memory area */
+#ifndef HASSTRINGHEAP
   for (i = himem; i <= b + bfind_object.size - 1; i++) memwrite2(i, 0);
 
   /* set the number of variables to the new value */
   himem = b + bfind_object.size - 1;
+#else
+  /* the strings of the freed objects go away with them */
+  strcompact(b + bfind_object.size - 1, 0);
+#endif
 
   if (DEBUG) {
     outsc("** bfree returns ");
@@ -1143,6 +1358,9 @@ address_t bfree(name_t* name) {
 
   /* forget the chache, because heap structure has changed !! */
   zeroheap(&bfind_object);
+#ifdef HASDARTMOUTH
+  zeroheap(&fncache);
+#endif
   return himem;
 }
 
@@ -1150,11 +1368,149 @@ address_t bfree(name_t* name) {
 address_t blength(name_t* name) {
   if (bfind(name)) return bfind_object.size; else return 0;
 }
+
+#ifdef HASSTRINGHEAP
+/*
+   The string heap. Strings are blocks between himem and strhimem, below
+   all other objects. A block is the payload, its capacity and the address
+   of the string slot owning it. This header is on top of the block, the
+   heap is walked from strhimem down. The slot of a string holds the length
+   and the address and capacity of the payload. A string that grows gets a
+   new block and its old block is marked free with owner 0. Free blocks are
+   only reclaimed when the heap is compacted, this happens if memory runs
+   out or objects are freed.
+*/
+
+/* move the string heap down by l bytes to make room for an object */
+void strshift(address_t l) {
+  address_t t, o, c;
+
+  if (himem < strhimem) {
+    memmove_block(himem + 1 - l, himem + 1, strhimem - himem);
+    for (t = strhimem - l; t > himem - l; t -= c + 2 * addrsize) {
+      o = getaddress(t - addrsize + 1, memread2);
+      c = getaddress(t - 2 * addrsize + 1, memread2);
+      if (o) setaddress(o + strindexsize, memwrite2, t - 2 * addrsize - c + 1);
+    }
+    for (t = strhimem - l + 1; t <= strhimem; t++) memwrite2(t, 0);
+  }
+  himem -= l;
+}
+
+/*
+   compact the string heap and let it end at h, all blocks owned by objects
+   below h are freed, the string s is moved along with its block. Blocks
+   are trimmed to the length of their string and the slack.
+*/
+void strcompact(address_t h, string_t* s) {
+  address_t t, d, o, c, p, q, n;
+
+  for (t = strhimem, d = h; t > himem; t -= c + 2 * addrsize) {
+    o = getaddress(t - addrsize + 1, memread2);
+    c = getaddress(t - 2 * addrsize + 1, memread2);
+    if (o > h) {
+      p = t - c - 2 * addrsize + 1;
+      n = getstrlength(o, memread2) + STRINGHEAPSLACK;
+      if (n > c) n = c;
+      q = d - n - 2 * addrsize + 1;
+      if (q != p) {
+        memmove_block(q, p, n);
+        setaddress(q + n, memwrite2, n);
+        setaddress(q + n + addrsize, memwrite2, o);
+        setaddress(o + strindexsize, memwrite2, q);
+        setaddress(o + strindexsize + addrsize, memwrite2, n);
+        if (s && s->address >= p && s->address < p + n) {
+          s->address = s->address - p + q;
+#ifndef USEMEMINTERFACE
+          s->ir = (char *)&mem[s->address];
+#endif
+        }
+      }
+      d -= n + 2 * addrsize;
+    }
+  }
+
+  /* clear the free memory */
+  for (t = himem + 1; t <= d; t++) memwrite2(t, 0);
+  himem = d;
+  strhimem = h;
+}
+
+/*
+   A view of a string points into the payload of a block. If an object is
+   created or freed while an expression is evaluated, the block moves.
+   strviewbase() remembers the payload of the view and strrebase() moves
+   the view along with its block. Views without a slot or a block stay.
+*/
+address_t strviewbase(string_t* s) {
+  if (!s->slot || !s->address) return 0;
+  return getaddress(s->slot + strindexsize, memread2);
+}
+
+void strrebase(string_t* s, address_t b) {
+  address_t p;
+
+  if (!b) return;
+  p = getaddress(s->slot + strindexsize, memread2);
+  if (!p || p == b) return;
+  s->address = s->address - b + p;
+#ifndef USEMEMINTERFACE
+  if (s->ir) s->ir = (char *)&mem[s->address];
+#endif
+}
+
+/*
+   make the string s big enough for n bytes, b is the position s points to,
+   the string t is kept valid if the heap is compacted
+*/
+void strensure(string_t* s, address_t b, address_t n, string_t* t) {
+  address_t p, c, nc, a;
+
+  c = getaddress(s->slot + strindexsize + addrsize, memread2);
+  if (n <= c) return;
+
+  /* a string that grows gets some slack, compact if there is no room */
+  nc = n + n / 2 + STRINGHEAPSLACK;
+  if (nc > s->strdim) nc = s->strdim;
+  if (himem - top < nc + 2 * addrsize) {
+    strcompact(strhimem, t);
+    if (himem - top < nc + 2 * addrsize) nc = n;
+    if (himem - top < nc + 2 * addrsize) {
+      error(EOUTOFMEMORY);
+      return;
+    }
+  }
+
+  /* the new block right below the heap */
+  a = himem - nc - 2 * addrsize + 1;
+  setaddress(a + nc, memwrite2, nc);
+  setaddress(a + nc + addrsize, memwrite2, s->slot);
+  himem = a - 1;
+
+  /* copy the old payload and free its block */
+  p = getaddress(s->slot + strindexsize, memread2);
+  if (p) {
+    memmove_block(a, p, s->length);
+    setaddress(p + c + addrsize, memwrite2, 0);
+  }
+  setaddress(s->slot + strindexsize, memwrite2, a);
+  setaddress(s->slot + strindexsize + addrsize, memwrite2, nc);
+
+  /* the string now points to the new block */
+  s->address = a + b - 1;
+#ifndef USEMEMINTERFACE
+  s->ir = (char *)&mem[s->address];
+#endif
+}
+#endif
 #endif /* HASAPPLE1 */
 
 /* reimplementation of getvar and setvar with name_t */
 number_t getvar(name_t *name) {
   address_t a;
+#ifdef HASDARTMOUTH
+  number_t* p;
+#endif
 
   if (DEBUG) {
     outsc("* getvar ");
@@ -1165,7 +1521,7 @@ number_t getvar(name_t *name) {
 
   /* the special variables */
   if (name->c[0] == '@') {
-#ifdef HASLONGNAMES
+#if defined(HASLONGNAMES) && !defined(HASNAMEIDS)
     if (name->l == 1) name->c[1] = 0; /* to make sure @ alone works */
 #endif
     switch (name->c[1]) {
@@ -1208,12 +1564,21 @@ number_t getvar(name_t *name) {
     }
   }
 
+#ifdef HASDARTMOUTH
+  /* the parameter of a running function */
+  if (fnframesp > 0 && (p = fnvariable(name))) return *p;
+#endif
+
 #ifdef HASAPPLE1
   /* search the heap first */
   a = bfind(name);
   if (!USELONGJUMP && er) return 0;
 
   /* if we don't find on the heap and it is not a static variable, we autocreate */
+  /* on the string heap reading does not create, this would move the string heap */
+#ifdef HASSTRINGHEAP
+  if (a == 0) return 0;
+#endif
   if (a == 0) {
     a = bmalloc(name, 0);
     if (!USELONGJUMP && er) return 0;
@@ -1240,6 +1605,9 @@ number_t getvar(name_t *name) {
 /* set and create a variable */
 void setvar(name_t *name, number_t v) {
   address_t a;
+#ifdef HASDARTMOUTH
+  number_t* p;
+#endif
 
   if (DEBUG) {
     outsc("* setvar ");
@@ -1269,6 +1637,9 @@ void setvar(name_t *name, number_t v) {
         return;
       case 'R':
         rd = v;
+#ifdef HASFLOAT
+        rndseed(rd);
+#endif
         return;
 #ifdef HASTEFANSEXT
       case 'U':
@@ -1298,6 +1669,14 @@ void setvar(name_t *name, number_t v) {
 #endif
     }
 
+#ifdef HASDARTMOUTH
+  /* the parameter of a running function */
+  if (fnframesp > 0 && (p = fnvariable(name))) {
+    *p = v;
+    return;
+  }
+#endif
+
 #ifdef HASAPPLE1
   /* dynamically allocated vars */
   a = bfind(name);
@@ -1342,11 +1721,17 @@ void clrvars() {
 
   /* reset the heap start*/
   himem = memsize;
+#ifdef HASSTRINGHEAP
+  strhimem = memsize;
+#endif
 
   /* and clear the cache */
 #ifdef HASAPPLE1
   zeroheap(&bfind_object);
 #endif
+#ifdef HASDARTMOUTH
+  zeroheap(&fncache);
+#endif
 }
 
 /*
@@ -1447,8 +1832,13 @@ void setstrlength(address_t m, memwriter_t f, stringlength_t s) {
    Currently the old code with twobyte names is still in place
    if HASLONGNAMES is not defined. Default is now to have long names.
 
+   With HASNAMEIDS the twobyte code is used for long names as well.
+   The lexer interns names longer than two characters into the name
+   pool, the name is then the offset in the pool with the high bit
+   of the first byte set. Program, heap and stacks only see two bytes.
+
 */
-#ifndef HASLONGNAMES
+#if !defined(HASLONGNAMES) || defined(HASNAMEIDS)
 
 /* this one is for the heap were we count down writing*/
 address_t setname_heap(address_t m, name_t* name) {
@@ -1457,6 +1847,11 @@ address_t setname_heap(address_t m, name_t* name) {
   return m;
 }
 
+/* the number of bytes a name needs on the heap */
+address_t heapnamesize(name_t* name) {
+  return 2;
+}
+
 /* this one is for the pgm were we count up writing */
 address_t setname_pgm(address_t m, name_t* name) {
   memwrite2(m++, name->c[0]);
@@ -1496,12 +1891,72 @@ void zeroheap(heap_t* heap) {
   zeroname(&heap->name);
 }
 
-/* output a name */
+/* output a name, interned names come from the pool */
 void outname(name_t* name) {
+#ifdef HASNAMEIDS
+  address_t a, i;
+  if (name->c[0] < 0) {
+    a = ((address_t)(name->c[0] & 0x7f) << 8) + (unsigned char) name->c[1];
+    if (a < namepooltop) for (i = 1; i <= namepool[a]; i++) outch(namepool[a + i]);
+    return;
+  }
+#endif
   outch(name->c[0]);
   if (name->c[1]) outch(name->c[1]);
 }
 
+#ifdef HASNAMEIDS
+/* 
+ * find the l characters in c in the name pool or add them, 
+ * returns the offset of the name in the pool, NAMEPOOLSIZE 
+ * if the pool is full
+ */
+address_t poolname(mem_t* c, mem_t l) {
+  address_t a;
+  mem_t i;
+
+  for (a = 0; a < namepooltop; a += namepool[a] + 1) {
+    if (namepool[a] != l) continue;
+    for (i = 0; i < l && namepool[a + 1 + i] == c[i]; i++);
+    if (i == l) return a;
+  }
+
+  if (namepooltop + l + 1 > NAMEPOOLSIZE) {
+    error(EOUTOFMEMORY);
+    return NAMEPOOLSIZE;
+  }
+  namepool[a] = l;
+  for (i = 0; i < l; i++) namepool[a + 1 + i] = c[i];
+  namepooltop += l + 1;
+  return a;
+}
+
+/* 
+ * make a name from the l characters in c, short names are stored as is,
+ * the name is not changed if the pool is full 
+ */
+void internname(name_t* name, mem_t* c, mem_t l) {
+  address_t a;
+
+  if (l <= 2) {
+    name->l = l;
+    name->c[0] = c[0];
+    name->c[1] = (l == 2) ? c[1] : 0;
+  } else {
+    a = poolname(c, l);
+    if (a == NAMEPOOLSIZE) return;
+    name->l = l;
+    name->c[0] = (mem_t) (0x80 | (a >> 8));
+    name->c[1] = (mem_t) (a & 0xff);
+  }
+}
+
+/* forget all interned names, only done for a new program */
+void clrnames() {
+  namepooltop = 0;
+}
+#endif
+
 #else
 /* this one is for the heap were we count down writing*/
 address_t setname_heap(address_t m, name_t* name) {
@@ -1511,6 +1966,11 @@ address_t setname_heap(address_t m, name_t* name) {
   return m;
 }
 
+/* the number of bytes a name needs on the heap */
+address_t heapnamesize(name_t* name) {
+  return name->l + 1;
+}
+
 /* this one is for the pgm were we count up writing */
 address_t setname_pgm(address_t m, name_t* name) {
   mem_t l;
@@ -1776,9 +2236,14 @@ void array(lhsobject_t* object, mem_t getset, number_t* value) {
   }
 #endif
 
-  /* set or get the array */
+  /* set or get the array, through the memory interface as one block */
+#ifdef USEMEMINTERFACE
+  if (getset == 'g') memread_block(a, (char*) value, numsize);
+  else if (getset == 's') memwrite_block(a, (char*) value, numsize);
+#else
   if (getset == 'g') *value = getnumber(a, memread2);
   else if (getset == 's') setnumber(a, memwrite2, *value);
+#endif
 }
 
 /*
@@ -1805,6 +2270,11 @@ address_t createstring(name_t* variable, address_t i, address_t j) {
   /* the MS string compatibility, DIM 10 creates 11 elements */
   if (msarraylimits) j += 1;
 
+  /* on the string heap only the slots are created, strings grow later */
+#ifdef HASSTRINGHEAP
+  i = 2 * addrsize;
+#endif
+
 #ifndef HASMULTIDIM
   /* if no string arrays are in the code, we reserve the number of bytes i and space for the index */
   /* allow redimension without check right now, for local variables */
@@ -1872,6 +2342,9 @@ void getstring(string_t* strp, name_t* name, address_t b, address_t j) {
   strp->length = 0;
   strp->arraydim = 1;
   strp->strdim = 0;
+#ifdef HASSTRINGHEAP
+  strp->slot = 0;
+#endif
 
   if (DEBUG) {
     outsc("* getstring from var "); outname(name); outspc();
@@ -1929,7 +2402,31 @@ void getstring(string_t* strp, name_t* name, address_t b, address_t j) {
   /* string creating has caused an error, typically no memoryy */
   if (!USELONGJUMP && er) return;
 
-#ifndef HASMULTIDIM
+#ifdef HASSTRINGHEAP
+  /* the slot of the string, length, address and capacity of the payload */
+#ifdef HASMULTIDIM
+  strp->arraydim = getaddress(ax + bfind_object.size - addrsize, memread2);
+  if ((j < arraylimit) || (j >= strp->arraydim + arraylimit )) {
+    error(EORANGE);
+    return;
+  }
+  ax = ax + (j - arraylimit) * (strindexsize + 2 * addrsize);
+#endif
+  strp->slot = ax;
+
+  /* a string can grow to the maximum length */
+  strp->strdim = (stringlength_t) -1;
+  if ((b < 1) || (b > strp->strdim )) {
+    error(EORANGE);
+    return;
+  }
+
+  strp->length = getstrlength(ax, memread2);
+
+  /* a string without a block points to its slot, it has length 0 */
+  if (!(ax = getaddress(ax + strindexsize, memread2))) ax = strp->slot + strindexsize;
+  ax = ax + b - 1;
+#elif !defined(HASMULTIDIM)
   /* the maximum length of the string */
   strp->strdim = bfind_object.size - strindexsize;
 
@@ -2053,7 +2550,9 @@ void setstringlength(name_t* name, address_t l, address_t j) {
   }
 
   /* stringdim calculation moved here */
-#ifndef HASMULTIDIM
+#ifdef HASSTRINGHEAP
+  stringdim = 2 * addrsize;
+#elif !defined(HASMULTIDIM)
   stringdim = bfind_object.size - strindexsize;
 #else
   /* getaddress seeks the dimension of the string array directly after the payload */
@@ -2072,6 +2571,24 @@ void setstringlength(name_t* name, address_t l, address_t j) {
   setstrlength(a, memwrite2, l);
 }
 
+/* copy n bytes of a C buffer to the lefthandside string s found by getstring and set its length */
+void setstringbuffer(lhsobject_t* lhs, string_t* s, char* b, address_t n) {
+#ifdef HASSTRINGHEAP
+  strensure(s, lhs->i, lhs->i + n - 1, 0);
+  if (!USELONGJUMP && er) return;
+  if (n > 0) memwrite_block(s->address, b, n);
+#else
+  address_t i;
+
+  if (s->ir) {
+    for (i = 0; i < n; i++) s->ir[i] = b[i];
+  } else {
+    memwrite_block(s->address, b, n);
+  }
+#endif
+  setstringlength(&lhs->name, lhs->i + n - 1, lhs->j);
+}
+
 /* the BASIC string mechanism for real time clocks, create a string with the clock data */
 #ifdef HASCLOCK
 void rtcmkstr() {
@@ -2310,6 +2827,9 @@ void error(token_t e) {
 
   /* reset fncontext - this is odd */
   fncontext = 0;
+#ifdef HASDARTMOUTH
+  fnframesp = 0;
+#endif
 
   /* we return to the statement loop, bringing the error with us */
 #if USELONGJUMP == 1
@@ -2481,7 +3001,7 @@ void clearst() {
 }
 
 /* these are not really stack operations but a way to handle temp char data (not needed right now) */
-address_t charsp;
+BSTATE address_t charsp;
 
 void pushchar(char ch) {}
 
@@ -2496,6 +3016,9 @@ void clrdata() {
 #ifdef HASDARTMOUTH
   data = 0;
 #endif
+#ifdef HASDATAINDEX
+  dataindexstate = 0;
+#endif
 }
 
 /*
@@ -2564,6 +3087,10 @@ void pushloop(name_t* name, token_t t, address_t here, number_t to, number_t ste
         loopstack[loopsp].var = *name;
 #if defined(HASAPPLE1) && defined(HASLOOPOPT)
         loopstack[loopsp].varaddress = bfind(name);
+#ifdef HASDARTMOUTH
+        /* function parameters are not on the heap */
+        if (fnframesp > 0 && fnvariable(name)) loopstack[loopsp].varaddress = 0;
+#endif
 #else
         loopstack[loopsp].varaddress = 0;
 #endif
@@ -2970,8 +3497,12 @@ address_t writenumber2(char *c, number_t vi) {
 
   /* pseudo integers are displayed as integer
   		zero trapped here */
+#ifndef HASINT64
   f = floor(vi);
   if (f == vi && fabs(vi) < maxnum) return writenumber(c, vi);
+#else
+  if (isint64(vi)) return writenumber(c, vi);
+#endif
 
   /* earlier, floats where displayed in POSIx using the libraties
      return sprintf(c, "%g", vi);
@@ -3381,6 +3912,7 @@ void nexttoken() {
   if (l > 0 && l <= MAXNAME) {
     token = VARIABLE;
     zeroname(&name);
+#ifndef HASNAMEIDS
     while (((*bi >= '0' && *bi <= '9') ||
             (*bi >= '@' && *bi <= 'Z') ||
             (*bi >= 'a' && *bi <= 'z') ||
@@ -3389,6 +3921,17 @@ void nexttoken() {
       bi++;
       name.l++;
     }
+#else
+    l = 0;
+    while (((*bi >= '0' && *bi <= '9') ||
+            (*bi >= '@' && *bi <= 'Z') ||
+            (*bi >= 'a' && *bi <= 'z') ||
+            (*bi == '_') ) && l < MAXNAME && *bi != 0) {
+      lexname[l++] = *bi;
+      bi++;
+    }
+    internname(&name, lexname, l);
+#endif
     if (*bi == '$') {
       token = STRINGVAR;
       bi++;
@@ -3545,10 +4088,30 @@ void storetoken() {
    The POSIX code has a test interface for SPIRAM as a dummy.
 
 */
+/* 
+   Execute in place. If the runtime has the EEPROM in memory, xipmem points 
+   to the program in it and the token stream is read from there directly. 
+   String constants point into the EEPROM instead of being copied. 
+   xiplength is the size of the program area, reads after it are -1 
+   like in eread().
+*/
+BSTATE mem_t* xipmem = 0;
+BSTATE address_t xiplength = 0;
+
+void xipbegin() {
+  xipmem = (mem_t*) eaddress();
+  if (xipmem) {
+    xipmem += eheadersize;
+    xiplength = elength() - eheadersize;
+  }
+}
+
 #ifndef USEMEMINTERFACE
 mem_t memread(address_t a) {
   if (st != SERUN) {
     return mem[a];
+  } else if (xipmem) {
+    if (a < xiplength) return xipmem[a]; else return -1;
   } else {
     return eread(a + eheadersize);
   }
@@ -3566,6 +4129,8 @@ void memwrite2(address_t a, mem_t c) {
 mem_t memread(address_t a) {
   if (st != SERUN) {
     return spiram_robufferread(a);
+  } else if (xipmem) {
+    if (a < xiplength) return xipmem[a]; else return -1;
   } else {
     return eread(a + eheadersize);
   }
@@ -3581,7 +4146,9 @@ void memwrite2(address_t a, mem_t c) {
 #else
 #ifdef EEPROMMEMINTERFACE
 mem_t memread(address_t a) {
-  if (a < elength() - eheadersize) return eread(a + eheadersize); else return mem[a - (elength() - eheadersize)];
+  if (a < elength() - eheadersize) {
+    if (xipmem) return xipmem[a]; else return eread(a + eheadersize);
+  } else return mem[a - (elength() - eheadersize)];
 }
 
 mem_t memread2(address_t a) {
@@ -3595,6 +4162,50 @@ void memwrite2(address_t a, mem_t c) {
 #endif
 #endif
 
+/*
+   Block access to the memory. Strings and array elements are copied 
+   with these functions. The SPI RAM transfers a block in one transaction,
+   other memory interfaces go byte by byte through memread2/memwrite2.
+   memmove_block copies in chunks of MEMBLOCKSIZE and handles overlaps.
+*/
+void memread_block(address_t a, char* b, address_t l) {
+#if defined(SPIRAMINTERFACE) || defined(SPIRAMSIMULATOR)
+  spiram_blockread(a, (int8_t*) b, l);
+#else
+  while (l--) *b++ = memread2(a++);
+#endif
+}
+
+void memwrite_block(address_t a, char* b, address_t l) {
+#if defined(SPIRAMINTERFACE) || defined(SPIRAMSIMULATOR)
+  spiram_blockwrite(a, (int8_t*) b, l);
+#else
+  while (l--) memwrite2(a++, *b++);
+#endif
+}
+
+void memmove_block(address_t d, address_t s, address_t l) {
+  char b[MEMBLOCKSIZE];
+  address_t n;
+
+  if (d == s) return;
+  if (s > d) {
+    while (l > 0) {
+      n = (l > MEMBLOCKSIZE) ? MEMBLOCKSIZE : l;
+      memread_block(s, b, n);
+      memwrite_block(d, b, n);
+      s += n; d += n; l -= n;
+    }
+  } else {
+    while (l > 0) {
+      n = (l > MEMBLOCKSIZE) ? MEMBLOCKSIZE : l;
+      l -= n;
+      memread_block(s + l, b, n);
+      memwrite_block(d + l, b, n);
+    }
+  }
+}
+
 
 /* get a token from memory */
 void gettoken() {
@@ -3638,13 +4249,18 @@ void gettoken() {
       sr.length = (unsigned char)memread(here++);
 
       /*
-        	if we run from EEPROM, the input buffer is used to get string constants.
+        	if we run from EEPROM, the input buffer is used to get string constants
+          unless the EEPROM can be read in place.
           if we run on a system with real memory, we produce a mem pointer
           otherwise the caller has to handle strings through the address (SPIRAM systems)
       */
       if (st == SERUN) {
-        for (i = 0; i < sr.length; i++) ibuffer[i] = memread(here + i);
-        sr.ir = ibuffer;
+        if (xipmem && here + sr.length <= xiplength) {
+          sr.ir = (char*)&xipmem[here];
+        } else {
+          for (i = 0; i < sr.length; i++) ibuffer[i] = memread(here + i);
+          sr.ir = ibuffer;
+        }
       } else {
 #ifndef USEMEMINTERFACE
         sr.ir = (char*)&mem[here];
@@ -3692,14 +4308,17 @@ typedef struct {
   address_t l;
   address_t h;
 } linecacheentry;
-linecacheentry linecache[LINECACHESIZE];
-unsigned char linecachehere = 0;
+BSTATE linecacheentry linecache[LINECACHESIZE];
+BSTATE unsigned char linecachehere = 0;
 
 void clrlinecache() {
   unsigned char i;
 
   for (i = 0; i < linecachedepth; i++) linecache[i].l = linecache[i].h = 0;
   linecachehere = 0;
+#ifdef HASJUMPTABLES
+  clrjumptables();
+#endif
 }
 
 void addlinecache(address_t l, address_t h) {
@@ -3717,7 +4336,11 @@ address_t findinlinecache(address_t l) {
   return 0;
 }
 #else
-void clrlinecache() {}
+void clrlinecache() {
+#ifdef HASJUMPTABLES
+  clrjumptables();
+#endif
+}
 void addlinecache(address_t l, address_t h) {}
 address_t findinlinecache(address_t l) {
   return 0;
@@ -3754,17 +4377,278 @@ void findline(address_t l) {
   error(ELINE);
 }
 
-/* finds the line of a location */
-address_t myline(address_t h) {
-  address_t l = 0;
-  address_t l1 = 0;
-  address_t here2;
+/*
+   Jump tables for ON GOTO/GOSUB and SWITCH. A statement with constant
+   line numbers or CASE labels is compiled the first time it is run.
+   The table maps the selector to a location in the program. Tables
+   are found by the location of the statement in a set associative cache
+   with JUMPWAYS tables per set, the least recently used one is replaced.
+   All tables are cleared together with the line cache. The targets of
+   ON are found lazily with findline() when they are used first. If the
+   entry pool is full, it is compacted, the entries of replaced tables
+   are freed this way. The labels of a SWITCH are sorted and searched
+   binary, a compact range of integer labels is filled to be indexed
+   directly.
+*/
+#ifdef HASJUMPTABLES
+BSTATE jumptable_t jumptables[JUMPTABLES];
+BSTATE number_t jumpvalue[JUMPENTRIES];
+BSTATE address_t jumptarget[JUMPENTRIES];
+BSTATE address_t jumpentries = 0;
 
-  here2 = here;
-  here = 0;
-  gettoken();
-  while (here < top) {
-    if (token == LINENUMBER) {
+void clrjumptables() {
+  int i;
+
+  for (i = 0; i < JUMPTABLES; i++) jumptables[i].state = 0;
+  jumpentries = 0;
+}
+
+/* 
+ * the table of a statement, an empty one if it is not compiled yet,
+ * the table found is moved to the front of its set 
+ */
+jumptable_t* findjumptable(address_t key) {
+  jumptable_t* s = &jumptables[(key % (JUMPTABLES / JUMPWAYS)) * JUMPWAYS];
+  jumptable_t t;
+  mem_t i;
+
+  for (i = 0; i < JUMPWAYS; i++) 
+    if (s[i].state != 0 && s[i].key == key) break;
+
+  /* not found, replace the last one */
+  if (i == JUMPWAYS) {
+    i = JUMPWAYS - 1;
+    s[i].key = key;
+    s[i].state = 0;
+  }
+
+  t = s[i];
+  for (; i > 0; i--) s[i] = s[i - 1];
+  s[0] = t;
+  return s;
+}
+
+/* move the entries of all compiled tables to the beginning of the pool */
+void compactjumpentries() {
+  jumptable_t* t;
+  address_t i, b = 0, d = 0;
+
+  for (;;) {
+
+    /* the table with the lowest entries not moved yet */
+    t = 0;
+    for (i = 0; i < JUMPTABLES; i++)
+      if (jumptables[i].state > 0 && jumptables[i].base >= b && (!t || jumptables[i].base < t->base)) 
+        t = &jumptables[i];
+    if (!t) break;
+    b = t->base + 1;
+
+    for (i = 0; i < t->n; i++) {
+      jumpvalue[d + i] = jumpvalue[t->base + i];
+      jumptarget[d + i] = jumptarget[t->base + i];
+    }
+    t->base = d;
+    d += t->n;
+  }
+  jumpentries = d;
+}
+
+/* add a value and a target to a table */
+mem_t addjumpentry(jumptable_t* t, number_t v, address_t a) {
+  if (jumpentries >= JUMPENTRIES) {
+    compactjumpentries();
+    if (jumpentries >= JUMPENTRIES) return 0;
+  }
+  jumpvalue[jumpentries] = v;
+  jumptarget[jumpentries++] = a;
+  t->n++;
+  return 1;
+}
+
+/* a table is done, the entries of a table that could not be compiled are freed */
+void endjumptable(jumptable_t* t, mem_t ok) {
+  if (ok) {
+    t->state = 1;
+  } else {
+    if (t->base + t->n == jumpentries) jumpentries = t->base;
+    t->n = 0;
+    t->state = -1;
+  }
+}
+
+/* 
+ * compile an ON statement, here is after GOTO or GOSUB, the values are 
+ * the line numbers, the targets are 0 until the line is found by xon()
+ */
+void makeontable(jumptable_t* t) {
+  address_t h = here;
+  token_t tk = token;
+  mem_t ok = 0;
+
+  t->base = jumpentries;
+  t->n = 0;
+  t->state = 2;
+  for (;;) {
+    gettoken();
+    if (token != NUMBER || x < 1 || x != (address_t) x) goto done;
+    if (!addjumpentry(t, x, 0)) goto done;
+    gettoken();
+    if (token != ',') break;
+  }
+  if (!termsymbol()) goto done;
+  t->end = here;
+  ok = 1;
+
+done:
+  endjumptable(t, ok);
+  here = h;
+  token = tk;
+}
+
+/* 
+ * compile a SWITCH statement, here is after the selector, the values 
+ * are the CASE labels, the targets the locations of the termsymbol 
+ * after the labels, the first label found wins
+ */
+void makeswitchtable(jumptable_t* t) {
+  address_t h = here;
+  token_t tk = token;
+  address_t i, a = 0, b;
+  mem_t s;
+  mem_t ok = 0;
+
+  t->base = jumpentries;
+  t->n = 0;
+  t->state = 2;
+  while (token != EOL) {
+    if (token == TSWEND) break;
+    if (token == TSWITCH) {
+      nexttoken();
+      findbraket(TSWITCH, TSWEND);
+      if (er) goto done;
+    }
+    if (token == TCASE) {
+      b = t->n;
+      for (;;) {
+        gettoken();
+        s = 1;
+        if (token == '-') {
+          s = -1;
+          gettoken();
+        }
+        if (token != NUMBER) goto done;
+        if (!addjumpentry(t, s * x, 0)) goto done;
+        a = here;
+        gettoken();
+        if (token != ',') break;
+      }
+      if (!termsymbol()) goto done;
+      for (i = t->base + b; i < t->base + t->n; i++) jumptarget[i] = a;
+    }
+    nexttoken();
+  }
+  sortjumptable(t);
+  ok = 1;
+
+done:
+  endjumptable(t, ok);
+  here = h;
+  token = tk;
+}
+
+/* 
+ * sort a SWITCH table by value, of equal values the first one stays, the 
+ * table is the last one in the pool while it is compiled
+ */
+void sortjumptable(jumptable_t* t) {
+  address_t i, j, n, r, b = t->base;
+  number_t v;
+  address_t a;
+
+  /* insertion sort, it is stable, equal labels keep their order */
+  for (i = 1; i < t->n; i++) {
+    v = jumpvalue[b + i];
+    a = jumptarget[b + i];
+    for (j = i; j > 0 && jumpvalue[b + j - 1] > v; j--) {
+      jumpvalue[b + j] = jumpvalue[b + j - 1];
+      jumptarget[b + j] = jumptarget[b + j - 1];
+    }
+    jumpvalue[b + j] = v;
+    jumptarget[b + j] = a;
+  }
+
+  /* remove the duplicates */
+  for (i = 0, n = 0; i < t->n; i++) {
+    if (n > 0 && jumpvalue[b + n - 1] == jumpvalue[b + i]) continue;
+    jumpvalue[b + n] = jumpvalue[b + i];
+    jumptarget[b + n++] = jumptarget[b + i];
+  }
+  jumpentries = b + n;
+  t->n = n;
+  t->dense = 0;
+
+  /* a compact range of labels with integer distances is filled, holes have target 0 */
+  if (n == 0 || jumpvalue[b + n - 1] - jumpvalue[b] >= 2 * n) return;
+  for (i = 0; i < n; i++) 
+    if (jumpvalue[b + i] - jumpvalue[b] != (address_t) (jumpvalue[b + i] - jumpvalue[b])) return;
+  r = jumpvalue[b + n - 1] - jumpvalue[b] + 1;
+  while (t->n < r) {
+    if (!addjumpentry(t, 0, 0)) {
+      t->n = n;
+      jumpentries = t->base + n;
+      return;
+    }
+  }
+
+  /* spread the entries from the top, the pool may have been compacted */
+  b = t->base;
+  v = jumpvalue[b];
+  for (i = r, j = n; i-- > 0; ) {
+    if (j > 0 && jumpvalue[b + j - 1] == v + i) {
+      j--;
+      jumptarget[b + i] = jumptarget[b + j];
+    } else {
+      jumptarget[b + i] = 0;
+    }
+    jumpvalue[b + i] = v + i;
+  }
+  t->dense = 1;
+}
+
+/* the target of a value in a SWITCH table, 0 if there is no such label */
+address_t findjumpentry(jumptable_t* t, number_t v) {
+  address_t b = t->base, l, h, m;
+
+  if (t->n == 0 || v < jumpvalue[b] || v > jumpvalue[b + t->n - 1]) return 0;
+
+  /* a filled table is indexed directly */
+  if (t->dense) {
+    m = b + (address_t) (v - jumpvalue[b]);
+    return (jumpvalue[m] == v) ? jumptarget[m] : 0;
+  }
+
+  /* the others are searched */
+  l = 0; 
+  h = t->n;
+  while (l < h) {
+    m = (l + h) / 2;
+    if (jumpvalue[b + m] < v) l = m + 1; else h = m;
+  }
+  return (l < t->n && jumpvalue[b + l] == v) ? jumptarget[b + l] : 0;
+}
+#endif
+
+/* finds the line of a location */
+address_t myline(address_t h) {
+  address_t l = 0;
+  address_t l1 = 0;
+  address_t here2;
+
+  here2 = here;
+  here = 0;
+  gettoken();
+  while (here < top) {
+    if (token == LINENUMBER) {
       l1 = l;
       l = ax;
     }
@@ -4163,52 +5047,130 @@ void xmap() {
    for float systems, use glibc parameters https://en.wikipedia.org/wiki/Linear_congruential_generator
 */
 
-void xrnd() {
-  number_t r;
-  mem_t base = randombase;
+#ifdef HASFLOAT
+/*
+   The floating point BASICs use xoshiro128** as random number generator.
+   There are RNDSTREAMS independent streams, SET 27,n selects one of them.
+   Seeding fills the state with splitmix32 and then jumps the stream number
+   times 2^64 numbers ahead, hence streams with the same seed never overlap.
+   A stream that was never seeded starts with the last seed set in any stream.
+   rd keeps the last number as 31 bit value for RND(0) and @R.
+*/
+uint32_t rndrotl(uint32_t x, mem_t k) {
+  return (x << k) | (x >> (32 - k));
+}
 
-  /* the argument of the RND() function */
-  r = pop();
+/* the next 32 bit number of the current stream, a fresh stream gets the last seed */
+uint32_t rndnext() {
+  uint32_t* s = rndstate[rndstream];
+  uint32_t r, t;
+
+  if (!(s[0] | s[1] | s[2] | s[3])) rndseed(rndseedvalue);
+
+  r = rndrotl(s[1] * 5, 7) * 9;
+  t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rndrotl(s[3], 11);
+  return r;
+}
+
+/* advance the current stream by 2^64 numbers */
+void rndjump() {
+  const uint32_t jump[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+  uint32_t* s = rndstate[rndstream];
+  uint32_t t[4] = { 0, 0, 0, 0 };
+  mem_t i, j, b;
+
+  for (i = 0; i < 4; i++)
+    for (b = 0; b < 32; b++) {
+      if (jump[i] & ((uint32_t)1 << b))
+        for (j = 0; j < 4; j++) t[j] ^= s[j];
+      (void) rndnext();
+    }
+  for (j = 0; j < 4; j++) s[j] = t[j];
+}
+
+/* seed the current stream */
+void rndseed(unsigned long v) {
+  uint32_t z, x = v;
+  mem_t i;
+
+  rndseedvalue = v;
+  for (i = 0; i < 4; i++) {
+    z = (x += 0x9e3779b9);
+    z = (z ^ (z >> 16)) * 0x85ebca6b;
+    z = (z ^ (z >> 13)) * 0xc2b2ae35;
+    rndstate[rndstream][i] = z ^ (z >> 16);
+  }
+  for (i = 0; i < rndstream; i++) rndjump();
+}
+
+/* select a stream, a fresh one is seeded right away with the last seed */
+void rndselect(mem_t n) {
+  uint32_t* s = rndstate[n];
+
+  rndstream = n;
+  if (!(s[0] | s[1] | s[2] | s[3])) rndseed(rndseedvalue);
+}
+#endif
+
+/*
+   RND(r) as a number, the modes set by SET 19 or the personality are
+   handled here
+*/
+number_t rndnumber(number_t r) {
+  mem_t base = randombase;
 
   /* this is the microsoft mode, argument <0 resets the sequence, 0 always the same number, > 1 a number between 0 and 1 */
   if (randombase < 0) {
     base = 0;
     if (r < 0) {
       rd = -r;
+#ifdef HASFLOAT
+      rndseed(rd);
+#endif
       r = 1;
     } else if (r == 0) {
       r = 1;
-      goto pushresult;
+      goto result;
     } else {
       r = 1;
     }
   }
 
-  /* this is the congruence */
+  /* the next number */
 #ifndef HASFLOAT
   /* the original 16 bit congruence, the & is needed to make it work for all kinds of ints */
   rd = (31421 * rd + 6927) & 0xffff;
 #else
-  /* glibc parameters */
-  rd = (110351245 * rd + 12345) & 0x7fffffff;
+  /* the upper 31 bits of xoshiro128** */
+  rd = rndnext() >> 1;
 #endif
 
-pushresult:
+result:
 
   /* the result is calculated with the right modulus */
 #ifndef HASFLOAT
   if (r >= 0)
-    push((unsigned long)rd * r / 0x10000 + base);
+    return (unsigned long)rd * r / 0x10000 + base;
   else
-    push((unsigned long)rd * r / 0x10000 + 1 - base);
+    return (unsigned long)rd * r / 0x10000 + 1 - base;
 #else
   if (r >= 0)
-    push(rd * r / 0x80000000 + base);
+    return rd * r / 0x80000000 + base;
   else
-    push(rd * r / 0x80000000 + 1 - base);
+    return rd * r / 0x80000000 + 1 - base;
 #endif
 }
 
+void xrnd() {
+  push(rndnumber(pop()));
+}
+
 
 #ifndef HASFLOAT
 /*
@@ -4255,8 +5217,95 @@ void xpow() {
 }
 
 /* while this is needed by ^*/
+/*
+ * The mixed integer mode. If both operands are integers in the int64 
+ * range, the operation is done in int64 and the result is exact. If 
+ * it overflows, the result is promoted to a long double floating point 
+ * number. The overflow checks are done before the operation as signed 
+ * overflow is undefined in C.
+ */
+#ifdef HASINT64
+mem_t isint64(number_t x) {
+  return x >= -9223372036854775808.0L && x < 9223372036854775808.0L && x == (int64_t) x;
+}
+
+/* does a*b fit into int64 */
+mem_t int64mulok(int64_t a, int64_t b) {
+  if (a == 0 || b == 0) return 1;
+  if (a > 0) return (b > 0) ? a <= INT64MAX / b : b >= INT64MIN / a;
+  return (b > 0) ? a >= INT64MIN / b : b >= INT64MAX / a;
+}
+
+number_t intadd(number_t x, number_t y) {
+  int64_t a, b;
+
+  if (isint64(x) && isint64(y)) {
+    a = x;
+    b = y;
+    if ((b > 0 && a <= INT64MAX - b) || (b <= 0 && a >= INT64MIN - b)) return a + b;
+  }
+  return x + y;
+}
+
+number_t intsub(number_t x, number_t y) {
+  int64_t a, b;
+
+  if (isint64(x) && isint64(y)) {
+    a = x;
+    b = y;
+    if ((b < 0 && a <= INT64MAX + b) || (b >= 0 && a >= INT64MIN + b)) return a - b;
+  }
+  return x - y;
+}
+
+number_t intmul(number_t x, number_t y) {
+  int64_t a, b;
+
+  if (isint64(x) && isint64(y)) {
+    a = x;
+    b = y;
+    if (int64mulok(a, b)) return a * b;
+  }
+  return x * y;
+}
+
+/* integer division and modulo, y is not 0 here, INT64MIN / -1 overflows */
+number_t intdiv(number_t x, number_t y) {
+  if (isint64(x) && isint64(y) && !(x == INT64MIN && y == -1)) return (int64_t) x / (int64_t) y;
+  return trunc(x / y);
+}
+
+number_t intmod(number_t x, number_t y) {
+  if (isint64(x) && isint64(y) && !(x == INT64MIN && y == -1)) return (int64_t) x % (int64_t) y;
+  return fmod(x, y);
+}
+
+/* integer powers by squaring, negative exponents are floating point */
+number_t intpow(number_t x, number_t y) {
+  int64_t b, r = 1, n;
+
+  if (isint64(x) && isint64(y) && y >= 0) {
+    b = x;
+    n = y;
+    for (;;) {
+      if (n & 1) {
+        if (!int64mulok(r, b)) break;
+        r *= b;
+      }
+      n >>= 1;
+      if (n == 0) return r;
+      if (!int64mulok(b, b)) break;
+      b *= b;
+    }
+  }
+  return pow(x, y);
+}
+#endif
+
 number_t bpow(number_t x, number_t y) {
-#ifdef HASFLOAT
+#if defined(HASINT64)
+  return intpow(x, y);
+#elif defined(HASFLOAT)
   return pow(x, y);
 #else
   number_t r;
@@ -4356,7 +5405,16 @@ void parsestringvar(string_t* strp, lhsobject_t* lhs) {
   /* in pure parse mode we end here. This is used for the lefthandside code */
   if (!strp) return;
 
-  /* try to get the string */
+  /* try to get the string, on the string heap reading does not create it */
+#ifdef HASSTRINGHEAP
+  if (lhs->name.c[0] != '@' && !bfind(&lhs->name)) {
+    strp->address = 0;
+    strp->ir = sbuffer;
+    strp->length = 0;
+    strp->strdim = 0;
+    strp->arraydim = 1;
+  } else
+#endif
   getstring(strp, &lhs->name, lhs->i, lhs->j);
   if (!USELONGJUMP && er) return;
 
@@ -4408,6 +5466,9 @@ char stringvalue(string_t* strp) {
   mem_t base = 10;
   number_t n;
 #endif
+#ifdef HASSTRINGHEAP
+  address_t b;
+#endif
 
   if (DEBUG) outsc("** entering stringvalue \n");
 
@@ -4417,6 +5478,9 @@ char stringvalue(string_t* strp) {
   strp->length = 0;
   strp->strdim = 0;
   strp->ir = 0;
+#ifdef HASSTRINGHEAP
+  strp->slot = 0;
+#endif
 
   switch (token) {
     case STRING:
@@ -4501,13 +5565,28 @@ char stringvalue(string_t* strp) {
         return 0;
       }
       nexttoken();
-      if (token != STRINGVAR) {
+
+      /* 
+       * the argument is a string variable or again a substring of one, the 
+       * result is a view into the variable and nothing is copied, temporary 
+       * strings in sbuffer could be overwritten by the expressions below
+       */
+      if (token == STRINGVAR) {
+        parsestringvar(strp, &lhs);
+      } else if (token == TRIGHT || token == TMID || token == TLEFT) {
+        if (!stringvalue(strp)) {
+          error(EARGS);
+          return 0;
+        }
+      } else {
         error(EARGS);
         return 0;
       }
-      parsestringvar(strp, &lhs);
       if (er != 0) return 0;
-      k = strp->length; /* the length of the original string variable */
+      k = strp->length; /* the length of the original string */
+#ifdef HASSTRINGHEAP
+      b = strviewbase(strp);
+#endif
       nexttoken();
       if (token != ',') {
         error(EARGS);
@@ -4554,6 +5633,11 @@ char stringvalue(string_t* strp) {
       }
       strp->length = l;
 
+      /* objects created by the arguments move the heap */
+#ifdef HASSTRINGHEAP
+      strrebase(strp, b);
+#endif
+
       if (token != ')') {
         error(EARGS);
         return 0;
@@ -4582,6 +5666,13 @@ void streval() {
   char* ir;
   address_t a;
   blocation_t l;
+#ifdef USEMEMINTERFACE
+  char b1[MEMBLOCKSIZE], b2[MEMBLOCKSIZE];
+  address_t i, n;
+#endif
+#ifdef HASSTRINGHEAP
+  address_t b;
+#endif
 
   /* is the right side of the expression a string */
   if (!stringvalue(&s1)) {
@@ -4589,6 +5680,9 @@ void streval() {
     return;
   }
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  b = strviewbase(&s1);
+#endif
 
   if (DEBUG) {
     outsc("** in streval first string");
@@ -4634,6 +5728,9 @@ void streval() {
     return;
   }
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  strrebase(&s1, b);
+#endif
 
   if (DEBUG) {
     outsc("** in streval result: ");
@@ -4651,8 +5748,11 @@ void streval() {
       if (s1.ir[k] != s2.ir[k]) goto neq;
     }
   else if (s1.address && s2.address)
-    for (k = 0; k < s1.length; k++) {
-      if (memread2(s1.address + k) != memread2(s2.address + k)) goto neq;
+    for (k = 0; k < s1.length; k += n) {
+      n = (s1.length - k > MEMBLOCKSIZE) ? MEMBLOCKSIZE : s1.length - k;
+      memread_block(s1.address + k, b1, n);
+      memread_block(s2.address + k, b2, n);
+      for (i = 0; i < n; i++) if (b1[i] != b2[i]) goto neq;
     }
   else {
     if (s1.address) {
@@ -4662,8 +5762,10 @@ void streval() {
       a = s2.address;
       ir = s1.ir;
     }
-    for (k = 0; k < s1.length; k++) {
-      if (memread2(a + k) != ir[k] ) goto neq;
+    for (k = 0; k < s1.length; k += n) {
+      n = (s1.length - k > MEMBLOCKSIZE) ? MEMBLOCKSIZE : s1.length - k;
+      memread_block(a + k, b1, n);
+      for (i = 0; i < n; i++) if (b1[i] != ir[k + i]) goto neq;
     }
   }
 #else
@@ -4707,6 +5809,403 @@ void xexp() {
 void xint() {
   push(floor(pop()));
 }
+
+#ifdef HASARRAYMATH
+/*
+   MAT B = F(A) applies the function F to all elements of the array A and
+   stores the results in B. A and B can be the same array, B needs at least
+   as many elements as A. F is SIN, COS, TAN, ATAN, LOG, EXP, SQR, INT or ABS.
+   MAT B = RND(x) fills B with random numbers RND(x).
+   The elements are processed in blocks of MATBLOCKSIZE numbers. SQR, ABS 
+   and INT use SIMD instructions with HASMATSIMD, matsimd() does as many
+   elements of a block as fit into the vectors and the scalar loop the rest.
+   The other functions call the maths library for each element.
+*/
+
+/* SQR, ABS and INT of the first elements of a block, returns how many are done */
+address_t matsimd(token_t f, number_t* v, address_t k) {
+  address_t i = 0;
+#ifdef HASMATSIMD
+  const address_t w = sizeof(simd_t) / sizeof(number_t);
+
+  switch (f) {
+    case TSQR:
+      for (; i + w <= k; i += w) SIMDSTORE(v + i, SIMDSQRT(SIMDLOAD(v + i)));
+      break;
+    case TABS:
+      for (; i + w <= k; i += w) SIMDSTORE(v + i, SIMDABS(SIMDLOAD(v + i)));
+      break;
+#ifdef SIMDFLOOR
+    case TINT:
+      for (; i + w <= k; i += w) SIMDSTORE(v + i, SIMDFLOOR(SIMDLOAD(v + i)));
+      break;
+#endif
+  }
+#endif
+  return i;
+}
+
+void matapply(token_t f, address_t d, address_t s, address_t n) {
+  number_t v[MATBLOCKSIZE];
+  address_t i, k;
+
+  while (n > 0) {
+    k = (n > MATBLOCKSIZE) ? MATBLOCKSIZE : n;
+    memread_block(s, (char *) v, k * numsize);
+    switch (f) {
+      case TSIN:
+        for (i = 0; i < k; i++) v[i] = sin(v[i]);
+        break;
+      case TCOS:
+        for (i = 0; i < k; i++) v[i] = cos(v[i]);
+        break;
+      case TTAN:
+        for (i = 0; i < k; i++) v[i] = tan(v[i]);
+        break;
+      case TATAN:
+        for (i = 0; i < k; i++) v[i] = atan(v[i]);
+        break;
+      case TLOG:
+        for (i = 0; i < k; i++) v[i] = log(v[i]);
+        break;
+      case TEXP:
+        for (i = 0; i < k; i++) v[i] = exp(v[i]);
+        break;
+      case TSQR:
+        for (i = matsimd(f, v, k); i < k; i++) v[i] = sqrt(v[i]);
+        break;
+      case TINT:
+        for (i = matsimd(f, v, k); i < k; i++) v[i] = floor(v[i]);
+        break;
+      case TABS:
+        for (i = matsimd(f, v, k); i < k; i++) v[i] = fabs(v[i]);
+        break;
+    }
+    memwrite_block(d, (char *) v, k * numsize);
+    s += k * numsize;
+    d += k * numsize;
+    n -= k;
+  }
+}
+
+/* fill n elements from d on with RND(r) */
+void matrnd(address_t d, address_t n, number_t r) {
+  number_t v[MATBLOCKSIZE];
+  address_t i, k;
+
+  while (n > 0) {
+    k = (n > MATBLOCKSIZE) ? MATBLOCKSIZE : n;
+    for (i = 0; i < k; i++) v[i] = rndnumber(r);
+    memwrite_block(d, (char *) v, k * numsize);
+    d += k * numsize;
+    n -= k;
+  }
+}
+
+#ifdef HASMATINPUT
+/*
+   MAT INPUT A reads the input file into the array A. Fields are separated
+   by commas, semicolons or tabs and rows by newlines. A two dimensional
+   array takes one row of the file per row, fields that do not fit are
+   skipped. Otherwise the fields fill the array one after the other. This
+   works for string arrays as well, string fields can be quoted. The file
+   is read in blocks, reading stops when the array is full and the rest
+   of the file stays available. MAT INPUT A, R, F stores the number of
+   rows read in R and the number of fields stored in F.
+*/
+
+/* store one field to a numeric or string array, returns 0 if the field is skipped */
+mem_t matinputfield(name_t* a, address_t d, address_t k, char* f, address_t l) {
+  number_t x = 0;
+  address_t i = 0;
+  mem_t s = 1;
+#ifdef HASAPPLE1
+  lhsobject_t lhs;
+  string_t sr;
+#endif
+
+#ifdef HASAPPLE1
+  /* strings go to the element k of the string array */
+  if (a->token == STRINGVAR) {
+    copyname(&lhs.name, a);
+    lhs.i = 1;
+    lhs.i2 = 0;
+    lhs.j = k + arraylimit;
+    lhs.ps = 1;
+    getstring(&sr, &lhs.name, lhs.i, lhs.j);
+    if (!USELONGJUMP && er) return 0;
+    if (l > sr.strdim) l = sr.strdim;
+    setstringbuffer(&lhs, &sr, f, l);
+    return 1;
+  }
+#endif
+
+  /* numbers, an empty field is 0, text is 0 and sets the error status */
+  f[l] = 0;
+  while (f[i] == ' ') i++;
+  if (f[i] == '-') {
+    s = -1;
+    i++;
+  } else if (f[i] == '+') i++;
+  if ((f[i] >= '0' && f[i] <= '9') || f[i] == '.') {
+#ifdef HASFLOAT
+    i += parsenumber2(&f[i], &x);
+#else
+    i += parsenumber(&f[i], &x);
+#endif
+    x *= s;
+  } else if (f[i] != 0) ert = 1;
+  setnumber(d + k * numsize, memwrite2, x);
+  return 1;
+}
+
+void xmatinput() {
+  name_t a;
+  lhsobject_t lr, lf;
+  char b[INPUTBLOCKSIZE]; /* the block of the file and the field */
+  char* f;
+  address_t fsize;
+  address_t m = 0, p = 0; /* the bytes in the block and the read position */
+  address_t l = 0; /* the length of the field */
+  address_t d = 0, n, dim = 1; /* address, number of elements and second dimension of the array */
+  address_t rows = 0, fields = 0, col = 0;
+  mem_t q = 0, qe = 0, results = 0; /* quote modes and the results flag */
+  int c;
+#ifdef HASAPPLE1
+  string_t s;
+#endif
+
+  /* the field goes to the input buffer while running like in INPUT */
+  if (st == SRUN || st == SERUN) {
+    f = ibuffer;
+    fsize = BUFSIZE;
+  } else {
+    f = sbuffer;
+    fsize = SBUFSIZE;
+  }
+
+  /* the array */
+  nexttoken();
+  if (token == VARIABLE) {
+    copyname(&a, &name);
+    a.token = ARRAYVAR;
+    if (!(d = bfind(&a))) {
+      error(EVARIABLE);
+      return;
+    }
+    n = bfind_object.size;
+#ifdef HASMULTIDIM
+    n -= addrsize;
+    dim = getaddress(d + n, memread2);
+#endif
+    n = n / numsize;
+#ifdef HASAPPLE1
+  } else if (token == STRINGVAR) {
+    copyname(&a, &name);
+    getstring(&s, &a, 1, arraylimit);
+    if (!USELONGJUMP && er) return;
+    n = s.arraydim;
+#endif
+  } else {
+    error(EUNKNOWN);
+    return;
+  }
+  nexttoken();
+
+  /* the optional variables for the number of rows and fields */
+  if (token == ',') {
+    nexttoken();
+    copyname(&lr.name, &name);
+    lefthandside(&lr);
+    if (!USELONGJUMP && er) return;
+    if (token != ',') {
+      error(EUNKNOWN);
+      return;
+    }
+    nexttoken();
+    copyname(&lf.name, &name);
+    lefthandside(&lf);
+    if (!USELONGJUMP && er) return;
+    results = 1;
+  }
+
+  /* one row per row of a two dimensional array */
+  if (dim > 1) n = n / dim;
+
+  /* the tokenizer, c is -1 at the end of the file */
+  while ((dim > 1 && rows < n) || (dim == 1 && fields < n)) {
+    if (p == m) {
+      m = fileblockread(b, INPUTBLOCKSIZE);
+      p = 0;
+    }
+    if (m == 0) c = -1; else c = (unsigned char) b[p++];
+
+    /* in quotes everything is part of the field */
+    if (q) {
+      if (c == '"') {
+        q = 0;
+        qe = 1;
+        continue;
+      }
+      if (c != -1) {
+        if (l < fsize - 1) f[l++] = c;
+        continue;
+      }
+    }
+
+    /* a double quote in a quoted field */
+    if (c == '"') {
+      if (qe && l < fsize - 1) f[l++] = '"';
+      q = 1;
+      continue;
+    }
+
+    if (c == -1 || c == '\n' || c == ',' || c == ';' || c == '\t') {
+
+      /* empty lines are skipped */
+      if (c != ',' && c != ';' && c != '\t' && col == 0 && l == 0 && !qe) {
+        if (c == -1) break;
+        continue;
+      }
+
+      /* store the field */
+      if (dim > 1) {
+        if (col < dim) fields += matinputfield(&a, d, rows * dim + col, f, l);
+      } else {
+        fields += matinputfield(&a, d, fields, f, l);
+      }
+      if (!USELONGJUMP && er) return;
+      col++;
+      l = 0;
+      qe = 0;
+
+      /* the end of a row */
+      if (c == '\n' || c == -1) {
+        rows++;
+        col = 0;
+      }
+      if (c == -1) break;
+      continue;
+    }
+
+    if (c != '\r' && l < fsize - 1) f[l++] = c;
+  }
+
+  /* a row cut short by a full array is counted */
+  if (col > 0) rows++;
+
+  /* give back what was read ahead */
+  if (p < m) (void) ifileseek(ifiletell() - (m - p));
+
+  if (results) {
+    assignnumber2(&lr, rows);
+    assignnumber2(&lf, fields);
+  }
+}
+#endif
+
+void xmat() {
+  name_t a, b;
+  token_t f;
+  address_t s, d, n;
+
+  /* the destination array */
+  nexttoken();
+#ifdef HASMATINPUT
+  if (token == TINPUT) {
+    xmatinput();
+    return;
+  }
+#endif
+  if (token != VARIABLE) {
+    error(EUNKNOWN);
+    return;
+  }
+  copyname(&b, &name);
+  b.token = ARRAYVAR;
+
+  nexttoken();
+  if (token != '=') {
+    error(EUNKNOWN);
+    return;
+  }
+
+  /* the function */
+  nexttoken();
+  f = token;
+  switch (f) {
+    case TSIN: case TCOS: case TTAN: case TATAN: case TLOG:
+    case TEXP: case TSQR: case TINT: case TABS: case TRND:
+      break;
+    default:
+      error(EUNKNOWN);
+      return;
+  }
+
+  /* the source array in brackets */
+  nexttoken();
+  if (token != '(') {
+    error(EUNKNOWN);
+    return;
+  }
+  nexttoken();
+
+  /* RND fills the destination with random numbers, the argument is a number */
+  if (f == TRND) {
+    expression();
+    if (!USELONGJUMP && er) return;
+    if (token != ')') {
+      error(EUNKNOWN);
+      return;
+    }
+    nexttoken();
+    if (!(d = bfind(&b))) {
+      error(EVARIABLE);
+      return;
+    }
+    n = bfind_object.size;
+#ifdef HASMULTIDIM
+    n -= addrsize;
+#endif
+    matrnd(d, n / numsize, pop());
+    return;
+  }
+
+  if (token != VARIABLE) {
+    error(EUNKNOWN);
+    return;
+  }
+  copyname(&a, &name);
+  a.token = ARRAYVAR;
+  nexttoken();
+  if (token != ')') {
+    error(EUNKNOWN);
+    return;
+  }
+  nexttoken();
+
+  /* both arrays must exist and the destination must be large enough */
+  if (!(s = bfind(&a))) {
+    error(EVARIABLE);
+    return;
+  }
+  n = bfind_object.size;
+  if (!(d = bfind(&b))) {
+    error(EVARIABLE);
+    return;
+  }
+  if (bfind_object.size < n) {
+    error(EORANGE);
+    return;
+  }
+
+  /* multidim arrays store their dimension after the elements */
+#ifdef HASMULTIDIM
+  n -= addrsize;
+#endif
+  matapply(f, d, s, n / numsize);
+}
+#endif
 #else
 void xint() {}
 #endif
@@ -4803,6 +6302,7 @@ void factorlen() {
       push(s.length);
       nexttoken();
       break;
+    /* string functions deliver a view, only the length is needed */
 #ifdef HASMSSTRINGS
     case TRIGHT:
     case TLEFT:
@@ -4810,8 +6310,14 @@ void factorlen() {
     case TCHR:
 #endif
     case TSTR:
-      error(EARGS);
-      return;
+      if (!stringvalue(&s)) {
+        error(EARGS);
+        return;
+      }
+      if (!USELONGJUMP && er) return;
+      push(s.length);
+      nexttoken();
+      break;
     default:
       expression();
       if (!USELONGJUMP && er) return;
@@ -4983,6 +6489,9 @@ void factorinstr() {
   char ch;
   address_t a;
   string_t s;
+#ifdef HASSTRINGHEAP
+  address_t b;
+#endif
 
   nexttoken();
   if (token != '(') {
@@ -4996,6 +6505,9 @@ void factorinstr() {
     return;
   }
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  b = strviewbase(&s);
+#endif
   nexttoken();
 
   if (token != ',') {
@@ -5006,6 +6518,9 @@ void factorinstr() {
   nexttoken();
   expression();
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  strrebase(&s, b);
+#endif
 
   ch = pop();
   if (s.address) {
@@ -5033,6 +6548,9 @@ void factorinstr() {
   address_t i = 1;
   string_t search;
   string_t s;
+#ifdef HASSTRINGHEAP
+  address_t b, bs;
+#endif
 
   nexttoken();
   if (token != '(') {
@@ -5047,6 +6565,9 @@ void factorinstr() {
     return;
   }
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  b = strviewbase(&s);
+#endif
   nexttoken();
 
   if (token != ',') {
@@ -5061,6 +6582,9 @@ void factorinstr() {
     return;
   }
   if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+  bs = strviewbase(&search);
+#endif
   nexttoken();
 
   /* potentially the start value */
@@ -5078,6 +6602,12 @@ void factorinstr() {
     return;
   }
 
+  /* the heap may have moved while the arguments were evaluated */
+#ifdef HASSTRINGHEAP
+  strrebase(&s, b);
+  strrebase(&search, bs);
+#endif
+
   /* health check */
   if (search.length == 0 || search.length + a > s.length || a == 0) {
     push(0);
@@ -5164,8 +6694,17 @@ void factorasc() {
       nexttoken();
       break;
     default:
-      error(EARGS);
-      return;
+      /* the other string functions, the first character of the view */
+      if (!stringvalue(&s)) {
+        error(EARGS);
+        return;
+      }
+      if (!USELONGJUMP && er) return;
+      if (s.length > 0) {
+        if (s.ir) push(s.ir[0]); else push(memread2(s.address));
+      } else
+        push(0);
+      nexttoken();
   }
 
   if (!USELONGJUMP && er) return;
@@ -5208,6 +6747,9 @@ void factor() {
       parsefunction(xrnd, 1);
       break;
     case TSIZE:
+#ifdef HASSTRINGHEAP
+      strcompact(strhimem, 0);
+#endif
       push(himem - top);
       break;
       /* Apple 1 BASIC functions */
@@ -5426,7 +6968,11 @@ nextfactor:
   if (token == '*') {
     parseoperator(power);
     if (!USELONGJUMP && er) return;
+#ifndef HASINT64
     push(x * y);
+#else
+    push(intmul(x, y));
+#endif
     goto nextfactor;
   } else if (token == '/') {
     parseoperator(power);
@@ -5434,8 +6980,10 @@ nextfactor:
     if (y != 0)
 #ifndef HASFLOAT
       push(x / y);
+#elif !defined(HASINT64)
+        if (forceint) push((wnumber_t)x / (wnumber_t)y); else push(x / y);
 #else
-        if (forceint) push((int)x / (int)y); else push(x / y);
+        if (forceint) push(intdiv(x, y)); else push(x / y);
 #endif
     else {
       error(EDIVIDE);
@@ -5448,8 +6996,10 @@ nextfactor:
     if (y != 0)
 #ifndef HASFLOAT
       push(x % y);
+#elif !defined(HASINT64)
+      push((wnumber_t)x % (wnumber_t)y);
 #else
-      push((int)x % (int)y);
+      push(intmod(x, y));
 #endif
     else {
       error(EDIVIDE);
@@ -5481,7 +7031,11 @@ nextfactor:
   if (token == '*') {
     parseoperator(factor);
     if (!USELONGJUMP && er) return;
+#ifndef HASINT64
     push(x * y);
+#else
+    push(intmul(x, y));
+#endif
     goto nextfactor;
   } else if (token == '/') {
     parseoperator(factor);
@@ -5489,8 +7043,10 @@ nextfactor:
     if (y != 0)
 #ifndef HASFLOAT
       push(x / y);
+#elif !defined(HASINT64)
+        if (forceint) push((wnumber_t)x / (wnumber_t)y); else push(x / y);
 #else
-        if (forceint) push((int)x / (int)y); else push(x / y);
+        if (forceint) push(intdiv(x, y)); else push(x / y);
 #endif
     else {
       error(EDIVIDE);
@@ -5503,8 +7059,10 @@ nextfactor:
     if (y != 0)
 #ifndef HASFLOAT
       push(x % y);
+#elif !defined(HASINT64)
+      push((wnumber_t)x % (wnumber_t)y);
 #else
-      push((int)x % (int)y);
+      push(intmod(x, y));
 #endif
     else {
       error(EDIVIDE);
@@ -5543,12 +7101,20 @@ nextterm:
   if (token == '+' ) {
     parseoperator(term);
     if (!USELONGJUMP && er) return;
+#ifndef HASINT64
     push(x + y);
+#else
+    push(intadd(x, y));
+#endif
     goto nextterm;
   } else if (token == '-') {
     parseoperator(term);
     if (!USELONGJUMP && er) return;
+#ifndef HASINT64
     push(x - y);
+#else
+    push(intsub(x, y));
+#endif
     goto nextterm;
   }
 }
@@ -5690,10 +7256,7 @@ processsymbol:
     if (!USELONGJUMP && er) return;
 
     /* buffer must be used here for machine code to work */
-#ifdef USEMEMINTERFACE
-    if (!s.ir) getstringtobuffer(&s, spistrbuf1, SPIRAMSBSIZE);
-#endif
-    outs(s.ir, s.length);
+    outstring(&s);
 
     nexttoken();
     goto separators;
@@ -5861,6 +7424,10 @@ void assignnumber2(lhsobject_t* lhs, number_t x) {
       /* find the string variable */
       getstring(&sr, &lhs->name, lhs->i, lhs->j);
       if (!USELONGJUMP && er) return;
+#ifdef HASSTRINGHEAP
+      strensure(&sr, lhs->i, lhs->i, 0);
+      if (!USELONGJUMP && er) return;
+#endif
 
       /* the first character of the string is set to the number */
       if (sr.ir) sr.ir[0] = x; else if (sr.address) memwrite2(ax, x); else error(EUNKNOWN);
@@ -5913,6 +7480,12 @@ void assignment() {
 #ifdef HASAPPLE1
     /* the lefthandside is a string variable, try evaluate the righthandside as a stringvalue */
     case STRINGVAR:
+
+      /* creating the destination moves the string heap, do it before the source is evaluated */
+#ifdef HASSTRINGHEAP
+      getstring(&sl, &lhs.name, lhs.i, lhs.j);
+      if (!USELONGJUMP && er) return;
+#endif
 nextstring:
 
       /* do we deal with a string as righthand side */
@@ -5968,6 +7541,12 @@ nextstring:
       if (lhs.i2 > 0) copybytes = ((lhs.i2 - lhs.i + 1) > sr.length) ? sr.length : (lhs.i2 - lhs.i + 1);
       else copybytes = sr.length;
 
+      /* the destination grows, the source stays valid */
+#ifdef HASSTRINGHEAP
+      strensure(&sl, lhs.i, lhs.i + copybytes - 1, &sr);
+      if (!USELONGJUMP && er) return;
+#endif
+
       if (DEBUG) {
         outsc("** assignment copybytes ");
         outnumber(copybytes);
@@ -6016,7 +7595,9 @@ nextstring:
    and C memory strings.
 */
 void assignstring(string_t* sl, string_t* sr, stringlength_t copybytes) {
+#ifndef USEMEMINTERFACE
   stringlength_t k;
+#endif
 
   /* if we have a memory model that needs the mem interface, go through the addresses by default
   	else use just the pointers */
@@ -6025,18 +7606,15 @@ void assignstring(string_t* sl, string_t* sr, stringlength_t copybytes) {
   /* for a regular string variable as left hand side we know the address */
   if (sl->address) {
 
-    /* for a regular string variable as a source we need to take care of order */
+    /* for a regular string variable as a source memmove_block takes care of order */
 
     if (sr->address) {
-      if (sr->address > sl->address)
-        for (k = 0; k < copybytes; k++) memwrite2(sl->address + k, memread2(sr->address + k));
-      else
-        for (k = 1; k <= copybytes; k++) memwrite2(sl->address + copybytes - k, memread2(sr->address + copybytes - k));
+      memmove_block(sl->address, sr->address, copybytes);
     } else {
 
       /* if the right hand side is a special string or a constant things are much simpler */
 
-      for (k = 0; k < copybytes; k++) memwrite2(sl->address + k, sr->ir[k]);
+      memwrite_block(sl->address, sr->ir, copybytes);
 
     }
   } else {
@@ -6078,6 +7656,9 @@ void xinput() {
 
   mem_t oldid = id; /* remember the stream on modify */
   mem_t prompt = 1; /* determine if we show the prompt */
+#ifdef HASINPUTEVENTS
+  address_t h = here; /* the location after INPUT, for the restart after timers */
+#endif
   number_t xv; /* for number conversion with innumber */
 
   /* the identifier of the lefthandside */
@@ -6131,10 +7712,7 @@ void xinput() {
 nextstring:
   if (token == STRING && id != IFILE) {
     prompt = 0;
-#ifdef USEMEMINTERFACE
-    if (!sr.ir) getstringtobuffer(&sr, spistrbuf1, SPIRAMSBSIZE);
-#endif
-    outs(sr.ir, sr.length);
+    outstring(&sr);
     nexttoken();
   }
 
@@ -6157,6 +7735,9 @@ again:
         /* if we have no buffer or are at the end, read it and set cursor k to the beginning */
         if (k == 0 || (address_t) buffer[0] < k) {
           if (prompt) showprompt();
+#ifdef HASINPUTEVENTS
+          if (!inputwait()) goto timerinput;
+#endif
           (void) ins(buffer, bufsize);
           k = 1;
         }
@@ -6227,9 +7808,20 @@ again:
 
         /* now read the string inplace */
         if (prompt) showprompt();
-#ifndef USEMEMINTERFACE
+#ifdef HASINPUTEVENTS
+        if (!inputwait()) goto timerinput;
+#endif
+#if defined(HASSTRINGHEAP)
+        /* read to the buffer and then let the string grow */
+        if (maxlen > bufsize - 1) maxlen = bufsize - 1;
+        newlength = ins(buffer, maxlen);
+        strensure(&s, lhs.i, lhs.i + newlength - 1, 0);
+        if (!USELONGJUMP && er) return;
+        if (newlength > 0) memwrite_block(s.address, buffer + 1, newlength);
+#elif !defined(USEMEMINTERFACE)
         newlength = ins(s.ir - 1, maxlen);
 #else
+        if (maxlen > SPIRAMSBSIZE - 1) maxlen = SPIRAMSBSIZE - 1;
         newlength = ins(spistrbuf1, maxlen);
 
         /* if we have a string variable, we need to copy the buffer to the string */
@@ -6237,7 +7829,7 @@ again:
           if (s.ir) {
             for (k = 0; k < newlength; k++) s.ir[k] = spistrbuf1[k + 1];
           } else {
-            for (k = 0; k < newlength; k++) memwrite2(s.address + k, spistrbuf1[k + 1]);
+            memwrite_block(s.address, spistrbuf1 + 1, newlength);
           }
         }
 #endif
@@ -6268,6 +7860,19 @@ again:
 resetinput:
   id = oldid;
   form = 0;
+  return;
+
+  /* 
+   * a timer is due, pretend to be at the : before INPUT, the statement loop 
+   * then calls the timer code and a GOSUB returns to INPUT 
+   */
+#ifdef HASINPUTEVENTS
+timerinput:
+  here = h;
+  token = ':';
+  id = oldid;
+  form = 0;
+#endif
 }
 
 /*
@@ -6751,10 +8356,7 @@ void outputtoken() {
       break;
     case STRING:
       outch('"');
-#ifdef USEMEMINTERFACE
-      if (!sr.ir) getstringtobuffer(&sr, spistrbuf1, SPIRAMSBSIZE);
-#endif
-      outs(sr.ir, sr.length);
+      outstring(&sr);
       outch('"');
       break;
     default:
@@ -7018,6 +8620,26 @@ endnosave:
 /*
  	RUN and CONTINUE are the same function
 */
+/* all reset on run */
+void resetrunstate() {
+  clrvars();
+  clrgosubstack();
+  clrforstack();
+  clrdata();
+  clrlinecache();
+  ert = 0;
+  ioer = 0;
+  fncontext = 0;
+#ifdef HASDARTMOUTH
+  fnframesp = 0;
+#endif
+#ifdef HASEVENTS
+  resettimer(&every_timer);
+  resettimer(&after_timer);
+  events_enabled = 1;
+#endif
+}
+
 void xrun() {
   if (token == TCONT) {
     st = SRUN;
@@ -7037,22 +8659,7 @@ void xrun() {
     }
     if (!USELONGJUMP && er) return;
     if (st == SINT) st = SRUN;
-
-    /* all reset on run */
-    clrvars();
-    clrgosubstack();
-    clrforstack();
-    clrdata();
-    clrlinecache();
-    ert = 0;
-    ioer = 0;
-    fncontext = 0;
-#ifdef HASEVENTS
-    resettimer(&every_timer);
-    resettimer(&after_timer);
-    events_enabled = 1;
-#endif
-
+    resetrunstate();
     nexttoken();
   }
 
@@ -7195,6 +8802,9 @@ void resetbasicstate() {
 
   /* function context back to zero */
   fncontext = 0;
+#ifdef HASDARTMOUTH
+  fnframesp = 0;
+#endif
 
   /* interactive mode */
   st = SINT;
@@ -7221,8 +8831,17 @@ void xnew() {
 
   /* program memory back to zero and variable heap cleared */
   himem = memsize;
+#ifdef HASSTRINGHEAP
+  strhimem = memsize;
+#endif
   zeroblock(0, memsize);
   top = 0;
+#ifdef HASDARTMOUTH
+  zeroheap(&fncache);
+#endif
+#ifdef HASNAMEIDS
+  clrnames();
+#endif
 
   if (DEBUG) outsc("** clearing EEPROM state \n ");
   /* on EEPROM systems also clear the stored state and top */
@@ -7394,12 +9013,6 @@ nextvariable:
         error(EORANGE);
         return;
       }
-#ifdef SPIRAMSBSIZE
-      if (x > SPIRAMSBSIZE - 1) {
-        error(EORANGE);
-        return;
-      }
-#endif
       /* With the substringmode switched off, if only one argument is given
       	we interpret the argument as the string array dimension and not as
       	the length two arguments are allowed and work as always. This makes
@@ -7626,14 +9239,47 @@ void stringtobuffer(char *buffer, string_t* s) {
   }
 }
 
-/* helper for the memintercase code */
+/* 
+ * helper for the memintercase code, a string longer than the buffer is a 
+ * range error, the part that fits is still copied for the caller 
+ */
 void getstringtobuffer(string_t* strp, char *buffer, stringlength_t maxlen) {
-  stringlength_t i;
-
-  for (i = 0; i < strp->length && i < maxlen; i++) buffer[i] = memread2(strp->address + i);
+  if (strp->length > maxlen) {
+    error(EORANGE);
+    strp->length = maxlen;
+  }
+  memread_block(strp->address, buffer, strp->length);
   strp->ir = buffer;
 }
 
+/* 
+ * output a string, long strings in serial memory are streamed in 
+ * chunks, short ones are output in one piece for the block devices 
+ */
+void outstring(string_t* strp) {
+#ifdef USEMEMINTERFACE
+  char b[MEMBLOCKSIZE];
+  address_t a, l, n;
+
+  if (!strp->ir) {
+    if (strp->length < SPIRAMSBSIZE) {
+      getstringtobuffer(strp, spistrbuf1, SPIRAMSBSIZE);
+    } else {
+      a = strp->address;
+      l = strp->length;
+      while (l > 0) {
+        n = (l > MEMBLOCKSIZE) ? MEMBLOCKSIZE : l;
+        memread_block(a, b, n);
+        outs(b, n);
+        a += n; l -= n;
+      }
+      return;
+    }
+  }
+#endif
+  outs(strp->ir, strp->length);
+}
+
 /* get a file argument */
 void getfilename(char *buffer, char d) {
   index_t s;
@@ -7856,45 +9502,271 @@ void xload(const char* f) {
         }
       } else {
 
-        /* is there space to store the character */
-        if ((bi - ibuffer) > BUFSIZE - 1) {
-          error(EOUTOFMEMORY);
+        /* is there space to store the character */
+        if ((bi - ibuffer) > BUFSIZE - 1) {
+          error(EOUTOFMEMORY);
+          break;
+        }
+        *bi++ = ch;
+      }
+
+
+    }
+    ifileclose();
+    /* after a successful load we save top to the EEPROM header */
+#ifdef EEPROMMEMINTERFACE
+    setaddress(1, beupdate, top);
+#endif
+
+    /* go back to run mode and start from the first line */
+    if (chain) {
+      st = SRUN;
+      here = 0;
+      nexttoken();
+    }
+  }
+}
+#else
+/*
+ 	SAVE a file to EEPROM - minimal version for small Arduinos
+*/
+void xsave() {
+  esave();
+  nexttoken();
+}
+/*
+ 	LOAD a file from EEPROM - minimal version for small Arduinos
+*/
+void xload(const char* f) {
+  eload();
+  nexttoken();
+}
+#endif
+
+#ifdef HASRECORDIO
+/*
+   Binary records, GET #r and PUT #r read and write record r of the file
+   opened with OPEN "file", 3, recordsize. Records count from 0. Numbers
+   are stored in their native format with numsize bytes, A() stores all
+   elements of an array and a string is stored as its length followed by
+   the characters. Without a record size r is the byte position.
+*/
+
+/* parse # r, and position the input or the output file */
+mem_t recordseek(mem_t o) {
+  address_t r;
+
+  if (!expectexpr()) return 0;
+  r = popaddress();
+  if (!USELONGJUMP && er) return 0;
+  if (token != ',') {
+    error(EUNKNOWN);
+    return 0;
+  }
+  nexttoken();
+
+  recordbytes = 0;
+  if (o) {
+    if (!ofileseek((unsigned long) r * recordsize)) ert = 1;
+  } else {
+    if (!ifileseek((unsigned long) r * recordsize)) ert = 1;
+  }
+  return 1;
+}
+
+/* count the bytes of the record, a record cannot be longer than the record size */
+mem_t recordfits(address_t n) {
+  recordbytes += n;
+  if (recordsize > 1 && recordbytes > recordsize) {
+    error(EORANGE);
+    return 0;
+  }
+  return 1;
+}
+
+void recordwrite(char* b, address_t n) {
+  if (fileblockwrite(b, n) != n) ert = 1;
+}
+
+/* a short read is not an error, the missing bytes are 0 */
+void recordread(char* b, address_t n) {
+  address_t i;
+
+  i = fileblockread(b, n);
+  if (i != n) {
+    ert = 1;
+    for (; i < n; i++) b[i] = 0;
+  }
+}
+
+/* BASIC memory goes to and comes from the file in blocks */
+void recordwritemem(address_t a, address_t n) {
+  char b[RECORDBLOCKSIZE];
+  address_t k;
+
+  while (n > 0) {
+    k = (n > RECORDBLOCKSIZE) ? RECORDBLOCKSIZE : n;
+    memread_block(a, b, k);
+    recordwrite(b, k);
+    a += k;
+    n -= k;
+  }
+}
+
+void recordreadmem(address_t a, address_t n) {
+  char b[RECORDBLOCKSIZE];
+  address_t k;
+
+  while (n > 0) {
+    k = (n > RECORDBLOCKSIZE) ? RECORDBLOCKSIZE : n;
+    recordread(b, k);
+    memwrite_block(a, b, k);
+    a += k;
+    n -= k;
+  }
+}
+
+/* is the next item a whole array A(), return its address and its size in bytes */
+address_t recordarray(address_t* n) {
+  blocation_t l;
+  name_t a;
+  address_t ax;
+
+  if (token != ARRAYVAR) return 0;
+
+  pushlocation(&l);
+  copyname(&a, &name);
+  nexttoken();
+  if (token == '(') {
+    nexttoken();
+    if (token == ')') {
+      if (!(ax = bfind(&a))) {
+        error(EVARIABLE);
+        return 0;
+      }
+      *n = bfind_object.size;
+#ifdef HASMULTIDIM
+      *n -= addrsize;
+#endif
+      nexttoken();
+      return ax;
+    }
+  }
+
+  /* an array element or an expression, go back */
+  poplocation(&l);
+  copyname(&name, &a);
+  return 0;
+}
+
+/* PUT #r, writes numbers, arrays and strings */
+void xputrecord() {
+  address_t a, n;
+  number_t x;
+  string_t s;
+  stringlength_t l;
+
+  if (!recordseek(1)) return;
+
+  while (1) {
+    if ((a = recordarray(&n))) {
+      if (!recordfits(n)) return;
+      recordwritemem(a, n);
+    } else if (stringvalue(&s)) {
+      if (!USELONGJUMP && er) return;
+      l = s.length;
+      if (!recordfits(sizeof(l) + l)) return;
+      recordwrite((char *) &l, sizeof(l));
+      if (s.ir) recordwrite(s.ir, l); else recordwritemem(s.address, l);
+      nexttoken();
+    } else {
+      if (!USELONGJUMP && er) return;
+      expression();
+      if (!USELONGJUMP && er) return;
+      x = pop();
+      if (!recordfits(numsize)) return;
+      recordwrite((char *) &x, numsize);
+    }
+    if (token != ',') return;
+    nexttoken();
+  }
+}
+
+/* GET #r, reads numbers, arrays and strings */
+void xgetrecord() {
+  lhsobject_t lhs;
+  address_t a, n;
+  number_t x;
+#ifdef HASAPPLE1
+  string_t s;
+  stringlength_t l;
+  address_t maxlen;
+  char* buffer;
+  address_t bufsize;
+  char ch;
+
+  /* like in INPUT, strings are read to a buffer first */
+  if (st == SRUN || st == SERUN) {
+    buffer = ibuffer;
+    bufsize = BUFSIZE;
+  } else {
+    buffer = sbuffer;
+    bufsize = SBUFSIZE;
+  }
+#endif
+
+  if (!recordseek(0)) return;
+
+  while (1) {
+    if ((a = recordarray(&n))) {
+      if (!recordfits(n)) return;
+      recordreadmem(a, n);
+    } else if (token == VARIABLE || token == ARRAYVAR || token == STRINGVAR) {
+      copyname(&lhs.name, &name);
+      lefthandside(&lhs);
+      if (!USELONGJUMP && er) return;
+
+      switch (lhs.name.token) {
+        case VARIABLE:
+        case ARRAYVAR:
+          if (!recordfits(numsize)) return;
+          recordread((char *) &x, numsize);
+          assignnumber2(&lhs, x);
           break;
-        }
-        *bi++ = ch;
-      }
+#ifdef HASAPPLE1
+        case STRINGVAR:
+          if (!recordfits(sizeof(l))) return;
+          recordread((char *) &l, sizeof(l));
+          if (!recordfits(l)) return;
 
+          /* the destination and its maximum length */
+          getstring(&s, &lhs.name, lhs.i, lhs.j);
+          if (!USELONGJUMP && er) return;
+          if (lhs.i2 == 0) {
+            maxlen = s.strdim - lhs.i + 1;
+          } else {
+            maxlen = lhs.i2 - lhs.i + 1;
+            if (maxlen > s.strdim) maxlen = s.strdim - lhs.i + 1;
+          }
+          if (maxlen > bufsize) maxlen = bufsize;
 
-    }
-    ifileclose();
-    /* after a successful load we save top to the EEPROM header */
-#ifdef EEPROMMEMINTERFACE
-    setaddress(1, beupdate, top);
+          /* read what fits and skip the rest of the string */
+          n = (l > maxlen) ? maxlen : l;
+          recordread(buffer, n);
+          for (a = n; a < l; a++) recordread(&ch, 1);
+          setstringbuffer(&lhs, &s, buffer, n);
+          break;
 #endif
-
-    /* go back to run mode and start from the first line */
-    if (chain) {
-      st = SRUN;
-      here = 0;
-      nexttoken();
+      }
+    } else {
+      error(EUNKNOWN);
+      return;
     }
+    if (!USELONGJUMP && er) return;
+    if (token != ',') return;
+    nexttoken();
   }
 }
-#else
-/*
- 	SAVE a file to EEPROM - minimal version for small Arduinos
-*/
-void xsave() {
-  esave();
-  nexttoken();
-}
-/*
- 	LOAD a file from EEPROM - minimal version for small Arduinos
-*/
-void xload(const char* f) {
-  eload();
-  nexttoken();
-}
 #endif
 
 /*
@@ -7922,6 +9794,15 @@ void xget() {
     nexttoken();
   }
 
+#ifdef HASRECORDIO
+  /* a binary record from the file */
+  if (token == '#') {
+    xgetrecord();
+    id = oid;
+    return;
+  }
+#endif
+
   /* this code evaluates the left hand side - remember type and name */
   copyname(&lhs.name, &name);
 
@@ -7964,6 +9845,15 @@ void xput() {
     nexttoken();
   }
 
+#ifdef HASRECORDIO
+  /* a binary record to the file */
+  if (token == '#') {
+    xputrecord();
+    od = ood;
+    return;
+  }
+#endif
+
   parsearguments();
   if (!USELONGJUMP && er) return;
 
@@ -8104,8 +9994,8 @@ void xset() {
       radioset(argument);
       break;
 #endif
-      /* display update control for paged displays */
-#ifdef DISPLAYDRIVER
+      /* display update control for paged displays and the framebuffer */
+#if defined(DISPLAYDRIVER) || defined(POSIXFRAMEBUFFER)
     case 10:
       dspsetupdatemode(argument);
       break;
@@ -8183,6 +10073,24 @@ void xset() {
     case 24:
       precision = argument;
       break;
+#endif
+      /* the statement profiler, 1 clears and starts it, 0 stops it */
+#ifdef HASPROFILER
+    case 25:
+      profileswitch(argument);
+      break;
+#endif
+      /* the QoS of MQTT publish and subscribe */
+#ifdef HASMQTT
+    case 26:
+      mqttset(argument);
+      break;
+#endif
+      /* the random number stream */
+#ifdef HASFLOAT
+    case 27:
+      if (argument >= 0 && argument < RNDSTREAMS) rndselect(argument); else error(EORANGE);
+      break;
 #endif
   }
 }
@@ -8772,6 +10680,29 @@ void resettimer(btimer_t* t) {
   t->linenumber = 0;
 }
 
+/* would the statement loop trigger a timer now, same conditions as there */
+mem_t timerdue() {
+  if (fncontext != 0) return 0;
+  if (after_timer.enabled && millis() > after_timer.last + after_timer.interval) return 1;
+  if (every_timer.enabled && millis() > every_timer.last + every_timer.interval) return 1;
+  return 0;
+}
+
+/* 
+ * INPUT from the console waits here for an entire line, a timer that 
+ * becomes due ends the wait and INPUT is restarted after the timer code 
+ */
+#ifdef HASINPUTEVENTS
+mem_t inputwait() {
+  if (id != ISERIAL || (st != SRUN && st != SERUN)) return 1;
+  while (!serialline(YIELDINTERVAL)) {
+    if (timerdue()) return 0;
+    byield();
+  }
+  return 1;
+}
+#endif
+
 void xtimer() {
   token_t t;
   btimer_t* timer;
@@ -9127,6 +11058,9 @@ void xopen() {
   char stream = IFILE; /* default is file operation */
   char* filename;
   int mode;
+#ifdef HASRECORDIO
+  address_t size = 1;
+#endif
 
   /* which stream do we open? default is FILE */
   nexttoken();
@@ -9157,6 +11091,12 @@ void xopen() {
     mode = 0;
   } else if (args == 1) {
     mode = pop();
+#ifdef HASRECORDIO
+  } else if (args == 2) {
+    size = popaddress();
+    if (!USELONGJUMP && er) return;
+    mode = pop();
+#endif
   } else {
     error(EARGS);
     return;
@@ -9173,6 +11113,9 @@ void xopen() {
 #endif
 #ifdef FILESYSTEMDRIVER
     case IFILE:
+#ifdef HASRECORDIO
+      recordsize = (size > 0) ? size : 1;
+#endif
       switch (mode) {
         case 1:
           ofileclose();
@@ -9182,6 +11125,12 @@ void xopen() {
           ofileclose();
           if (ofileopen(filename, "a")) ert = 0; else ert = 1;
           break;
+#ifdef HASRECORDIO
+        /* random access, the file is open for read and write */
+        case 3:
+          if (rfileopen(filename)) ert = 0; else ert = 1;
+          break;
+#endif
         default:
         case 0:
           ifileclose();
@@ -9262,6 +11211,12 @@ void xclose() {
   switch (stream) {
     case IFILE:
       if (mode == 1 || mode == 2) ofileclose(); else if (mode == 0) ifileclose();
+#ifdef HASRECORDIO
+      if (mode == 3) {
+        ofileclose();
+        ifileclose();
+      }
+#endif
       break;
   }
 #endif
@@ -9380,6 +11335,17 @@ void xusr() {
           push(avgfastticker()); 
           clearfasttickerprofile();
           break;
+#endif
+#ifdef SPIRAMSIMULATOR
+        case 36: 
+        case 37: 
+        case 38: 
+        case 39: 
+        case 40: 
+        case 41: 
+        case 42: 
+          push(spiramstat(arg - 36)); 
+          break;
 #endif
         /* - 48 reserved, don't use */
         case 48: push(id); break;
@@ -9395,7 +11361,9 @@ void xusr() {
       break;
     /* access to properties of stream 2 - display and keyboard */
     case 2:
-#if defined(DISPLAYDRIVER) || defined(GRAPHDISPLAYDRIVER)
+#if defined(POSIXDISPLAY)
+      if (arg > 0) push(dspcounter(arg)); else push(dspstat(arg));
+#elif defined(DISPLAYDRIVER) || defined(GRAPHDISPLAYDRIVER)
       push(dspstat(arg));
 #elif defined(ARDUINOVGA)
       push(vgastat(arg));
@@ -9474,6 +11442,16 @@ void xcall() {
       mqttbegin();
 #endif
       break;
+#ifdef POSIXFRAMEBUFFER
+    /* show the back buffer of the framebuffer on the screen */
+    case 4:
+      dspgraphupdate();
+      break;
+    /* write the back buffer to a file */
+    case 5:
+      vgadump(FRAMEDUMPFILE);
+      break;
+#endif
     /* call values to 31 reserved! */
     default:
       /* your custom code into usrcall() */
@@ -9497,6 +11475,44 @@ void xdata() {
   while (!termsymbol()) nexttoken();
 }
 
+#ifdef HASDATAINDEX
+/*
+   Scan the program once and remember the address of every DATA item.
+   If the program has more items than the index or a malformed DATA 
+   statement, READ falls back to scanning, it reports the error then.
+*/
+void makedataindex() {
+  address_t h = here;
+  address_t a;
+
+  ndata = 0;
+  dataindexstate = -1;
+  here = 0;
+  while (here < top) {
+    gettoken();
+    if (token != TDATA) continue;
+    for (;;) {
+      a = here;
+      gettoken();
+      if (token == '-') gettoken();
+      if ((token != NUMBER && token != STRING) || ndata >= DATAINDEXSIZE) {
+        here = h;
+        return;
+      }
+      dataindex[ndata++] = a;
+      gettoken();
+      if (token != ',') break;
+    }
+    if (!termsymbol()) {
+      here = h;
+      return;
+    }
+  }
+  dataindexstate = 1;
+  here = h;
+}
+#endif
+
 /*
    for READ find the next data record, helper of READ
 */
@@ -9507,6 +11523,31 @@ void nextdatarecord() {
   /* save the location of the interpreter and the token we are processing */
   h = here;
 
+  /* with an index, the record number is all we need */
+#ifdef HASDATAINDEX
+  if (dataindexstate == 0) makedataindex();
+  if (dataindexstate == 1) {
+    if (data == 0) datarc = 1;
+    if (datarc > ndata) {
+      token = NUMBER;
+      x = 0;
+      ert = 1;
+      data = top;
+      return;
+    }
+    here = dataindex[datarc - 1];
+    gettoken();
+    if (token == '-') {
+      gettoken();
+      if (token == NUMBER) x = -x;
+    }
+    data = here;
+    datarc++;
+    here = h;
+    return;
+  }
+#endif
+
   /* data at zero means we need to init it, by searching the first data record */
   if (data == 0) {
     here = 0;
@@ -9665,6 +11706,10 @@ nextdata:
         }
 
         /* now write the string */
+#ifdef HASSTRINGHEAP
+        strensure(&s, lhs.i, lhs.i + sr.length - 1, &sr);
+        if (!USELONGJUMP && er) return;
+#endif
         assignstring(&s, &sr, sr.length);
 
         /* classical Apple 1 behaviour is string truncation in substring logic */
@@ -9714,6 +11759,19 @@ void xrestore() {
   /* we search a record */
   rec = pop();
 
+  /* with an index, this is only setting the record number */
+#ifdef HASDATAINDEX
+  if (dataindexstate == 0) makedataindex();
+  if (dataindexstate == 1) {
+    if (rec < 1) rec = 1;
+    if (rec > ndata + 1) rec = ndata + 1;
+    datarc = rec;
+    data = (rec <= ndata) ? dataindex[rec - 1] : top;
+    nexttoken();
+    return;
+  }
+#endif
+
   /* if we need to search backward, back to the beginning */
   if (rec < datarc) {
     data = 0;
@@ -9730,12 +11788,20 @@ void xrestore() {
 /*
    DEF a function, functions are tokenized as FN ARRAYVAR to make
    name processing easy.
+
+   The parameters and the LOCAL variables of a multiline function are 
+   collected here. Their position in the list is the slot index in the 
+   call frame. The names are bound once here, the function record gets 
+   a hash table from the names to the slots and the names after it. A 
+   function which is defined again reuses its record if the new names 
+   fit, otherwise a new record shadows the old one.
 */
 void xdef() {
-  address_t a;
-
+  address_t a, h, l, j;
+  mem_t n, nv, i;
+  token_t type;
   name_t function; /* the name of the function */
-  name_t variable; /* the name of the argument */
+  name_t variables[FNVARS]; /* the names of the parameters and locals */
 
   /*  do we define a function */
   if (!expect(TFN, EUNKNOWN)) return;
@@ -9746,41 +11812,81 @@ void xdef() {
   copyname(&function, &name);
   function.token = TFN; /* set the right type here */
 
-  /* the argument variable */
+  /* the parameter list */
   if (!expect('(', EUNKNOWN)) return;
   nexttoken();
-  if (token == ')') {
-    zeroname(&variable);
-  } else if (token == VARIABLE) {
-    copyname(&variable, &name);
+  n = 0;
+  while (token == VARIABLE) {
+    if (n >= FNVARS) {
+      error(EFUN);
+      return;
+    }
+    copyname(&variables[n++], &name);
     nexttoken();
-  } else {
-    error(EUNKNOWN);
-    return;
+    if (token != ',') break;
+    if (!expect(VARIABLE, EUNKNOWN)) return;
   }
   if (token != ')') {
     error(EUNKNOWN);
     return;
   }
 
-  /* which type of function do we store is found in token */
+  /* which type of function do we store is found in token, the code starts here */
   nexttoken();
+  h = here;
+  type = (token == '=') ? VARIABLE : 0;
 
-  /* ready to store the function */
   if (DEBUG) {
     outsc("** DEF FN with function ");
     outname(&function);
-    outsc(" and argument ");
-    outname(&variable);
-    outsc(" at here ");
+    outsc(" and ");
+    outnumber(n);
+    outsc(" arguments at here ");
     outnumber(here);
     outsc(" and token is ");
     outnumber(token);
     outcr();
   }
 
-  /* find the function, we allow redefinition, currently only functions with 1 argument */
-  if ((a = bfind(&function)) == 0) a = bmalloc(&function, 1);
+  /* skip the function body during defintion and collect the locals */
+  nv = n;
+  if (token == '=') {
+    while (!termsymbol()) nexttoken();
+  } else {
+#if defined(HASMULTILINEFUNCTIONS)
+    while (token != TFEND) {
+      nexttoken();
+      if (token == TDEF || token == EOL) {
+        error(EFUN);
+        return;
+      }
+      /* only numbers can be local */
+      if (token == TLOCAL) {
+        for (;;) {
+          nexttoken();
+          if (token != VARIABLE || nv >= FNVARS) {
+            error(EFUN);
+            return;
+          }
+          copyname(&variables[nv++], &name);
+          nexttoken();
+          if (token != ',') break;
+        }
+      }
+    }
+    nexttoken();
+#else
+    error(EFUN);
+    return;
+#endif
+  }
+
+  /* find the function, we allow redefinition, nothing is written before we have the space */
+  l = nv * (2 + FNNAMESIZE);
+  if ((a = bfind(&function)) == 0 || bfind_object.size < addrsize + 3 + l) {
+    a = bmalloc(&function, l);
+    zeroheap(&fncache);
+  }
   if (DEBUG) {
     outsc("** found function structure at ");
     outnumber(a);
@@ -9797,41 +11903,97 @@ void xdef() {
   /* store the payload */
 
   /* first the jump address */
-  setaddress(a, memwrite2, here);
+  setaddress(a, memwrite2, h);
   a = a + addrsize;
 
   /* the type of the return value - at the moment only numbers */
-  if (token == '=')
-    memwrite2(a++, VARIABLE);
-  else
-    memwrite2(a++, 0);
+  memwrite2(a++, type);
 
-  /* store the number of variables */
-  memwrite2(a++, 1);
+  /* store the number of parameters and locals */
+  memwrite2(a++, n);
+  memwrite2(a++, nv - n);
 
-  /* store the type and the entire name of the variables */
-  memwrite2(a++, variable.token);
-  setname_pgm(a, &variable);
-  a = a + sizeof(name_t) - 1; /* reserves space for redefinition of functions with different variable */
+  /* 
+   * the bind table has two entries per name, an entry is the slot plus one, 
+   * 0 is free, the names follow the table with a fixed size to index them
+   */
+  for (j = 0; j < 2 * nv; j++) memwrite2(a + j, 0);
+  for (i = 0; i < nv; i++) {
+    for (j = fnhash(&variables[i]) % (2 * nv); memread2(a + j); j = (j + 1) % (2 * nv));
+    memwrite2(a + j, i + 1);
+    setname_pgm(a + 2 * nv + i * FNNAMESIZE, &variables[i]);
+  }
+}
 
-  /* skip the function body during defintion */
-  if (token == '=') {
-    while (!termsymbol()) nexttoken();
-  } else {
-#if defined(HASMULTILINEFUNCTIONS)
-    while (token != TFEND) {
-      nexttoken();
-      if (token == TDEF || token == EOL) {
-        error(EFUN);
-        return;
-      }
-    }
-    nexttoken();
+/* the hash of a name in the bind table of a function */
+address_t fnhash(name_t* name) {
+#if !defined(HASLONGNAMES) || defined(HASNAMEIDS)
+  return (unsigned char) name->c[0] * 31 + (unsigned char) name->c[1];
 #else
-    error(EFUN);
-    return;
+  address_t h = 0;
+  mem_t l;
+
+  for (l = 0; l < name->l; l++) h = h * 31 + (unsigned char) name->c[l];
+  return h;
+#endif
+}
+
+/*
+   Functions are found with bfind() only once, the last function
+   is cached in fncache until the heap shrinks.
+*/
+address_t fnfind(name_t* name) {
+  address_t a;
+
+  if (fncache.address && cmpname(name, &fncache.name)) return fncache.address;
+  a = bfind(name);
+  if (a) {
+    copyname(&fncache.name, name);
+    fncache.address = a;
+  }
+  return a;
+}
+
+/* 
+ * the parameters and locals of the running function, the bind table of 
+ * the function gives the slot, 0 if name is not in the frame 
+ */
+number_t* fnvariable(name_t* name) {
+  fnframe_t* frame = &fnframes[fnframesp - 1];
+  address_t t, h;
+  mem_t s;
+  name_t v;
+
+  if (name->token != VARIABLE || frame->n == 0) return 0;
+  t = 2 * frame->n;
+  for (h = fnhash(name) % t; (s = memread2(frame->bind + h)); h = (h + 1) % t) {
+    getname(frame->bind + t + (s - 1) * FNNAMESIZE, &v, memread2);
+    if (cmpname(name, &v)) return &fnslots[frame->base + s - 1];
+  }
+  return 0;
+}
+
+/* remove a frame and free the variables the function body has created */
+void fnpopframe() {
+#ifndef HASSTRINGHEAP
+  address_t i;
 #endif
+  fnframe_t* frame = &fnframes[--fnframesp];
+
+#ifndef HASSTRINGHEAP
+  if (himem < frame->himem) {
+    for (i = himem; i <= frame->himem; i++) memwrite2(i, 0);
+    himem = frame->himem;
+    zeroheap(&bfind_object);
+    zeroheap(&fncache);
+  }
+#else
+  if (strhimem < frame->himem) {
+    strcompact(frame->himem, 0);
+    zeroheap(&bfind_object);
+    zeroheap(&fncache);
   }
+#endif
 }
 
 /*
@@ -9844,18 +12006,24 @@ void xdef() {
    m decides whether the stack should contain a return value (call from factor)
    or should be empty.
 
-   The new function code has local variable capability of the new heap.
+   The arguments are bound to the slots of a call frame on the frame stack 
+   and not to heap variables. The LOCAL variables of the function get slots 
+   right after the parameters. FNLIMIT is the number of frames, it limits 
+   the depth of recursion, FNSLOTS the number of slots of all frames. 
+   Variables created by the function code on the heap are local and removed 
+   when the frame is removed.
 */
 void xfn(mem_t m) {
   address_t a;
   address_t h1, h2;
-  name_t variable;
   token_t type;
+  mem_t n, np, nl, i;
+  fnframe_t* frame;
 
   /* the name of the function and its address */
   if (!expect(ARRAYVAR, EUNKNOWN)) return;
   name.token = TFN;
-  a = bfind(&name);
+  a = fnfind(&name);
   if (a == 0) {
     error(EUNKNOWN);
     return;
@@ -9869,16 +12037,18 @@ void xfn(mem_t m) {
     outcr();
   }
 
-  /* and the argument */
+  /* and the arguments */
   if (!expect('(', EUNKNOWN)) return;
   nexttoken();
-
-  /* if there is no argument, set it to zero */
-  if (token == ')') {
-    push(0);
-  } else {
-    expression();
-    if (!USELONGJUMP && er) return;
+  n = 0;
+  if (token != ')') {
+    for (;;) {
+      expression();
+      if (!USELONGJUMP && er) return;
+      n++;
+      if (token != ',') break;
+      nexttoken();
+    }
   }
   if (token != ')') {
     error(EUNKNOWN);
@@ -9904,40 +12074,37 @@ void xfn(mem_t m) {
     outcr();
   }
 
-  /* the number of variables is always one here */
-  a++;
-
-  /* what is the name of the variable, direct read as getname also gets a token */
-  /* skip the type here as not needed*/
-  // zeroname(&variable); /* fixes the obscure function namehandling bug not needed any more with copyname in place */
-  variable.token = memread2(a++);
-  (void) getname(a, &variable, memread2);
-  a = a + sizeof(name_t) - 1;
+  /* the number of parameters and locals, missing arguments are zero */
+  np = memread2(a++);
+  nl = memread2(a++);
+  if (n > np) {
+    error(EARGS);
+    return;
+  }
 
-  if (DEBUG) {
-    outsc("** found function variable ");
-    outname(&variable);
-    outcr();
+  /* a new frame, this is how deep we can go */
+  if (fnframesp >= FNLIMIT) {
+    error(EFUN);
+    return;
   }
-
-  /* create a local variable and store the value in it if there is a variable */
-  if (variable.c[0]) {
-    if (!bmalloc(&variable, 0)) {
-      error(EVARIABLE);
-      return;
-    }
-    setvar(&variable, pop());
-  } else {
-    /* create a dummy variable to make sure local variables are cleaned up */
-    variable.token = VARIABLE;
-    variable.c[0] = '_';
-    variable.c[1] = 0;
-    variable.l = 1;
-    if (!bmalloc(&variable, 0)) {
-      error(EVARIABLE);
-      return;
-    }
+  frame = &fnframes[fnframesp];
+  frame->base = fnframesp ? frame[-1].base + frame[-1].n : 0;
+  if (frame->base + np + nl > FNSLOTS) {
+    error(EFUN);
+    return;
   }
+  frame->bind = a;
+  frame->n = np + nl;
+#ifndef HASSTRINGHEAP
+  frame->himem = himem;
+#else
+  frame->himem = strhimem;
+#endif
+
+  /* bind the arguments, the last one is on top of the stack */
+  for (i = frame->n; i > 0; i--) 
+    fnslots[frame->base + i - 1] = (i <= n) ? pop() : 0;
+  fnframesp++;
 
   /* store here and then evaluate the function */
   h2 = here;
@@ -9961,9 +12128,8 @@ void xfn(mem_t m) {
      * For multiline functions we generate a new interpreter instance by 
      * calling statement(). The variable m decides whether the stack should
      * contain a return value (call from factor) or should be empty.
-     * fncontext counts and limits the depth of function calls. This is 
-     * important to avoid stack overflow. For this reason statement() 
-     * should not allocate a lot of memory on the C stack.
+     * fncontext counts the depth of the interpreter instances. For this 
+     * reason statement() should not allocate a lot of memory on the C stack.
      */
 
     if (DEBUG) {
@@ -9973,10 +12139,6 @@ void xfn(mem_t m) {
 
     nexttoken();
     fncontext++;
-    if (fncontext > FNLIMIT) {
-      error(EFUN);
-      return;
-    }
     statement();
     if (!USELONGJUMP && er) return;
     if (fncontext > 0) fncontext--; else error(EFUN);
@@ -9986,10 +12148,9 @@ void xfn(mem_t m) {
 #endif
   }
 
-  /* now that all the function stuff is done, return to here and set the variable right */
+  /* now that all the function stuff is done, return to here and remove the frame */
   here = h2;
-  (void) bfree(&variable);
-
+  fnpopframe();
 
   /* now, depending on how this was called, make things right, we remove
   	the return value from the stack and call nexttoken */
@@ -10008,6 +12169,10 @@ void xon() {
   int ci;
   token_t t;
   int line = 0;
+#ifdef HASJUMPTABLES
+  jumptable_t* jt;
+  address_t a;
+#endif
 
   /*  ON can do the ON ERROR and ON EVENT commands as well, in this BASIC
   		ERROR and EVENT can also be used without the ON */
@@ -10046,6 +12211,37 @@ void xon() {
   /* remember if we do gosub or goto */
   t = token;
 
+  /* a compiled ON statement jumps directly, a target is found once with findline() */
+#ifdef HASJUMPTABLES
+  if (st == SRUN || st == SERUN) {
+    jt = findjumptable(here);
+    if (jt->state == 0) makeontable(jt);
+    if (jt->state == 1) {
+      ci = (int)cr;
+      if (ci < 1 || ci > jt->n) {
+        here = jt->end;
+        nexttoken();
+        return;
+      }
+      ci = jt->base + ci - 1;
+      if (!(a = jumptarget[ci])) {
+        findline(jumpvalue[ci]);
+        if (!USELONGJUMP && er) return;
+        a = jumptarget[ci] = here;
+      }
+      if (t == TGOSUB) {
+        here = jt->end;
+        pushgosubstack(0);
+        if (!USELONGJUMP && er) return;
+      }
+      here = a;
+      token = LINENUMBER;
+      ax = jumpvalue[ci];
+      return;
+    }
+  }
+#endif
+
   /* how many arguments have we got here */
   nexttoken();
   parsearguments();
@@ -10225,11 +12421,31 @@ void xswitch() {
   mem_t match = 0;
   /* mem_t swcount = 0; // unused */
   blocation_t l;
+#ifdef HASJUMPTABLES
+  jumptable_t* jt;
+  address_t a;
+#endif
 
   /* lets look at the condition */
   if (!expectexpr()) return;
   r = pop();
 
+  /* a compiled SWITCH goes to the termsymbol after the matching CASE or stays */
+#ifdef HASJUMPTABLES
+  if (st == SRUN || st == SERUN) {
+    jt = findjumptable(here);
+    if (jt->state == 0) makeswitchtable(jt);
+    if (!USELONGJUMP && er) return;
+    if (jt->state == 1) {
+      if ((a = findjumpentry(jt, r))) {
+        here = a;
+        gettoken();
+      }
+      return;
+    }
+  }
+#endif
+
   /* remember where we are */
   pushlocation(&l);
 
@@ -10301,6 +12517,258 @@ void xcase() {
 #endif
 
 
+/*
+   The statement profiler, switched on and off with SET 25.
+
+   SET 25,1 clears the profile and starts it, SET 25,0 stops it.
+   Every line of the program gets a slot in a table ordered by the
+   address of the line. The table is built when profiling starts and
+   is rebuilt if the program changes. On each statement, the time
+   since the previous statement is booked on the line and the keyword
+   of the previous statement. The times are exclusive, statements in
+   a called function book their own time. Lines beyond the first
+   PROFILERSIZE lines share the extra slot after the table, its entry
+   in profileaddress is the start of the first of them or top.
+
+   PROFILE lists the 10 hottest lines and statements, PROFILE n the n
+   hottest, PROFILE "file", n writes the list to a file.
+*/
+#ifdef HASPROFILER
+/* long tokens go down to -255 */
+#define PROFILETOKENS 383
+
+BSTATE address_t profileaddress[PROFILERSIZE + 1];
+BSTATE address_t profilelinenumber[PROFILERSIZE];
+BSTATE unsigned long profilecount[PROFILERSIZE + 1];
+BSTATE unsigned long profiletime[PROFILERSIZE + 1];
+BSTATE unsigned long profiletokencount[PROFILETOKENS];
+BSTATE unsigned long profiletokentime[PROFILETOKENS];
+BSTATE index_t profilelines = 0;
+BSTATE address_t profiletop = 0;
+BSTATE index_t profilecurrent = -1;
+BSTATE token_t profiletoken = 0;
+BSTATE unsigned long profilelast = 0;
+BSTATE mem_t profiling = 0;
+
+/* clear all the counters */
+void profileclear() {
+  index_t i;
+
+  for (i = 0; i <= profilelines; i++) profilecount[i] = profiletime[i] = 0;
+  for (i = 0; i < PROFILETOKENS; i++) profiletokencount[i] = profiletokentime[i] = 0;
+  profilecurrent = -1;
+  profiletoken = 0;
+}
+
+/*
+   build the line table, gettoken() changes the interpreter state,
+   the token under the cursor is saved and restored here
+*/
+void profilebegin() {
+  address_t here2 = here;
+  token_t token2 = token;
+  number_t x2 = x;
+  address_t ax2 = ax;
+  name_t name2;
+  string_t sr2 = sr;
+  address_t a;
+
+  copyname(&name2, &name);
+  profilelines = 0;
+  profileaddress[0] = top;
+  here = 0;
+  while (here < top) {
+    a = here;
+    gettoken();
+    if (token == LINENUMBER) {
+      profileaddress[profilelines] = a;
+      if (profilelines == PROFILERSIZE) break;
+      profilelinenumber[profilelines++] = ax;
+      profileaddress[profilelines] = top;
+    }
+  }
+  profiletop = top;
+  profileclear();
+
+  here = here2;
+  token = token2;
+  x = x2;
+  ax = ax2;
+  copyname(&name, &name2);
+  sr = sr2;
+}
+
+/* the slot of the line containing address a, -1 if there is none */
+index_t profileindex(address_t a) {
+  index_t l = 0;
+  index_t r = profilelines;
+  index_t m;
+
+  if (a >= top || a < profileaddress[0]) return -1;
+  while (l < r) {
+    m = (l + r + 1) / 2;
+    if (profileaddress[m] <= a) l = m; else r = m - 1;
+  }
+  return l;
+}
+
+/* book the previous statement and count the new one */
+void profilestatement() {
+  unsigned long t = micros();
+  address_t a;
+
+  if (profilecurrent >= 0) profiletime[profilecurrent] += t - profilelast;
+  if (profiletoken) profiletokentime[profiletoken + 255] += t - profilelast;
+
+  if (profiletop != top) profilebegin();
+
+  /* here is behind the token, a is inside it, mostly we are in the same line */
+  a = here - 1;
+  if (profilecurrent < 0 || a < profileaddress[profilecurrent] || a >= top ||
+      (profilecurrent < profilelines && a >= profileaddress[profilecurrent + 1]))
+    profilecurrent = profileindex(a);
+
+  if (profilecurrent >= 0) profilecount[profilecurrent]++;
+  profiletoken = token;
+  profiletokencount[token + 255]++;
+
+  /* the time of the profiler itself is not counted */
+  profilelast = micros();
+}
+
+/* close the last statement when we go back to interactive mode */
+void profileend() {
+  unsigned long t = micros();
+
+  if (profilecurrent >= 0) profiletime[profilecurrent] += t - profilelast;
+  if (profiletoken) profiletokentime[profiletoken + 255] += t - profilelast;
+  profilecurrent = -1;
+  profiletoken = 0;
+}
+
+/* start or stop profiling, starting clears the profile */
+void profileswitch(mem_t on) {
+  if (on) {
+    profilebegin();
+    profilelast = micros();
+  } else if (profiling) profileend();
+  profiling = (on != 0);
+}
+
+/* the next entry in descending order of time and count after entry l */
+index_t profilenext(unsigned long* t, unsigned long* c, index_t n, index_t l) {
+  index_t i;
+  index_t b = -1;
+
+  for (i = 0; i < n; i++) {
+    if (c[i] == 0) continue;
+    if (l >= 0 && (t[i] > t[l] || (t[i] == t[l] && (c[i] > c[l] || (c[i] == c[l] && i <= l))))) continue;
+    if (b < 0 || t[i] > t[b] || (t[i] == t[b] && c[i] > c[b])) b = i;
+  }
+  return b;
+}
+
+/* unsigned long output as float number_t cannot hold long times, f works like form */
+void profilenumber(unsigned long n, index_t f) {
+  index_t nd;
+
+  nd = writenumber(sbuffer, n);
+  while (f < -nd) {
+    outspc();
+    f++;
+  }
+  outs(sbuffer, nd);
+  while (f > nd) {
+    outspc();
+    f--;
+  }
+}
+
+/* PROFILE ["file",] [n] */
+void xprofile() {
+  char filename[SBUFSIZE];
+  unsigned long total = 0;
+  index_t n = 10;
+  index_t i, j, k;
+  token_t t;
+  mem_t ood = od;
+
+  nexttoken();
+  filename[0] = 0;
+  if (token == STRING || token == STRINGVAR) {
+    getfilename(filename, 0);
+    if (!USELONGJUMP && er) return;
+    if (token == ',') nexttoken();
+  }
+
+  parsearguments();
+  if (!USELONGJUMP && er) return;
+  if (args > 1) {
+    error(EARGS);
+    return;
+  }
+  if (args == 1) n = pop();
+
+#ifdef FILESYSTEMDRIVER
+  if (filename[0]) {
+    if (!ofileopen(filename, "w")) {
+      error(EFILE);
+      return;
+    }
+    od = OFILE;
+  }
+#endif
+
+  for (i = 0; i <= profilelines; i++) total += profiletime[i];
+  if (total == 0) total = 1;
+
+  /* the hottest lines */
+  outsc("line            count   time(us)   %"); outcr();
+  for (k = 0, i = -1; k < n; k++) {
+    i = profilenext(profiletime, profilecount, profilelines, i);
+    if (i < 0) break;
+    profilenumber(profilelinenumber[i], 9);
+    profilenumber(profilecount[i], -12);
+    profilenumber(profiletime[i], -11);
+    profilenumber(profiletime[i] * 100 / total, -4);
+    outcr();
+  }
+
+  /* all lines after the table together */
+  if (profilecount[profilelines]) {
+    outscf("other", 9);
+    profilenumber(profilecount[profilelines], -12);
+    profilenumber(profiletime[profilelines], -11);
+    profilenumber(profiletime[profilelines] * 100 / total, -4);
+    outcr();
+  }
+
+  /* the hottest statements, assignments are shown as LET */
+  outsc("statement       count   time(us)   %"); outcr();
+  for (k = 0, i = -1; k < n; k++) {
+    i = profilenext(profiletokentime, profiletokencount, PROFILETOKENS, i);
+    if (i < 0) break;
+    t = i - 255;
+    if (t == VARIABLE || t == ARRAYVAR || t == STRINGVAR) t = TLET;
+    for (j = 0; gettokenvalue(j) != 0 && gettokenvalue(j) != t; j++);
+    if (gettokenvalue(j)) outscf(getkeyword(j), 9); else outscf("?", 9);
+    profilenumber(profiletokencount[i], -12);
+    profilenumber(profiletokentime[i], -11);
+    profilenumber(profiletokentime[i] * 100 / total, -4);
+    outcr();
+  }
+
+#ifdef FILESYSTEMDRIVER
+  if (filename[0]) {
+    od = ood;
+    ofileclose();
+  }
+#endif
+
+  nexttoken();
+}
+#endif
+
 /*
  	statement processes an entire basic statement until the end
  	of the line.
@@ -10336,6 +12804,10 @@ void statement() {
       debugtoken();
       outcr();
     }
+#endif
+#ifdef HASPROFILER
+    /* count and time the statements of a running program */
+    if (profiling && st != SINT && token != ':' && token != LINENUMBER) profilestatement();
 #endif
     switch (token) {
       case ':':
@@ -10595,6 +13067,14 @@ void statement() {
           return;
         }
         break;
+      case TLOCAL:
+        /* the locals have their slots already from DEF, only allowed in functions */
+        if (fncontext == 0) {
+          error(EFUN);
+          return;
+        }
+        while (!termsymbol()) nexttoken();
+        break;
 #endif
 #endif
 #ifdef HASSTEFANSEXT
@@ -10670,6 +13150,16 @@ void statement() {
       case TCAM:
         xcam();
         break;
+#endif
+#ifdef HASPROFILER
+      case TPROFILE:
+        xprofile();
+        break;
+#endif
+#ifdef HASARRAYMATH
+      case TMAT:
+        xmat();
+        break;
 #endif
       default:
         /*  strict syntax checking */
@@ -10769,6 +13259,15 @@ errorhandler:
     */
 
     if ((token == LINENUMBER || token == ':' || token == TNEXT) && (st == SERUN || st == SRUN)) {
+
+      /* a context has used its time slice and returns to the scheduler */
+#ifdef HASCONTEXTS
+      bcontextcount++;
+      if (bcontextbudget && fncontext == 0 && bcontextcount >= bcontextbudget) {
+        bcontextyield = 1;
+        return;
+      }
+#endif
       
 /* timer functions are processed before events */
 #ifdef HASTIMER
@@ -10858,6 +13357,346 @@ void displaybanner() {
 #endif
 }
 
+/*
+   Interpreter contexts. With HASCONTEXTS all interpreter variables are 
+   thread local, each thread runs its own BASIC. A context stores this 
+   state and the memory of one program. bstate() copies the state to a 
+   buffer if s is 1 and back if s is 0, with p == 0 it returns the size. 
+   bi is stored as an offset as ibuffer differs from thread to thread.
+   The profiler data stays with the thread.
+
+   bcontextbegin() keeps the state of a fresh interpreter, it is called 
+   in main() before setup(). Loading and running a context overwrites 
+   the interpreter state of the calling thread.
+
+   bcontextbudget is the number of statements a context may still run 
+   before statement() returns to the caller. 0 means no limit.
+*/
+#ifdef HASCONTEXTS
+char* bcontextdefault = 0;
+long bcontextsize = 0;
+
+#define STATECOPY(v) n += statecopy(p ? p + n : 0, (void*) &(v), sizeof(v), s)
+long bstate(char* p, mem_t s) {
+  long n = 0;
+  address_t bioffset = 0;
+
+  if (s && bi >= ibuffer && bi < ibuffer + BUFSIZE) bioffset = bi - ibuffer;
+  STATECOPY(bioffset);
+  if (!s && p) bi = ibuffer + bioffset;
+
+  STATECOPY(stack); 
+  STATECOPY(sp);
+  STATECOPY(sbuffer);
+  STATECOPY(ibuffer);
+#ifndef HASAPPLE1
+  STATECOPY(vars);
+#endif
+  STATECOPY(mem);
+  STATECOPY(himem);
+  STATECOPY(memsize);
+#ifdef HASSTRINGHEAP
+  STATECOPY(strhimem);
+#endif
+  STATECOPY(loopstack);
+  STATECOPY(loopsp);
+  STATECOPY(gosubstack);
+  STATECOPY(gosubsp);
+  STATECOPY(x);
+  STATECOPY(y);
+  STATECOPY(name);
+  STATECOPY(ax);
+  STATECOPY(sr);
+  STATECOPY(token);
+  STATECOPY(er);
+  STATECOPY(ert);
+  STATECOPY(st);
+  STATECOPY(here);
+  STATECOPY(top);
+  STATECOPY(form);
+  STATECOPY(msarraylimits);
+  STATECOPY(arraylimit);
+  STATECOPY(booleanmode);
+  STATECOPY(forceint);
+  STATECOPY(defaultstrdim);
+  STATECOPY(randombase);
+  STATECOPY(substringmode);
+  STATECOPY(reltab);
+  STATECOPY(lowercasenames);
+  STATECOPY(args);
+  STATECOPY(rd);
+#ifdef HASFLOAT
+  STATECOPY(rndstate);
+  STATECOPY(rndstream);
+  STATECOPY(rndseedvalue);
+#endif
+#ifdef HASRECORDIO
+  STATECOPY(recordsize);
+  STATECOPY(recordbytes);
+#endif
+  STATECOPY(debuglevel);
+#ifdef HASDARTMOUTH
+  STATECOPY(data);
+  STATECOPY(datarc);
+#endif
+#ifdef HASDATAINDEX
+  STATECOPY(dataindex);
+  STATECOPY(ndata);
+  STATECOPY(dataindexstate);
+#endif
+#ifdef HASNAMEIDS
+  STATECOPY(namepool);
+  STATECOPY(namepooltop);
+#endif
+#ifdef HASDARTMOUTH
+  STATECOPY(fnframes);
+  STATECOPY(fnframesp);
+  STATECOPY(fnslots);
+  STATECOPY(fncache);
+#endif
+#ifdef HASARGS
+  STATECOPY(bnointafterrun);
+#endif
+  STATECOPY(lastouttoken);
+  STATECOPY(spaceafterkeyword);
+  STATECOPY(outliteral);
+  STATECOPY(lexliteral);
+#ifdef HASAPPLE1
+  STATECOPY(bfind_object);
+#endif
+  STATECOPY(vlength);
+#ifdef HASTIMER
+  STATECOPY(after_timer);
+  STATECOPY(every_timer);
+#endif
+#ifdef HASEVENTS
+  STATECOPY(nevents);
+  STATECOPY(ievent);
+  STATECOPY(events_enabled);
+  STATECOPY(eventlist);
+  STATECOPY(gosubarg);
+#endif
+#ifdef HASERRORHANDLING
+  STATECOPY(berrorh);
+  STATECOPY(erh);
+#endif
+  STATECOPY(bpulseunit);
+  STATECOPY(breakcondition);
+  STATECOPY(fncontext);
+#ifdef HASFLOAT
+  STATECOPY(epsilon);
+  STATECOPY(precision);
+#endif
+#if defined(LINECACHESIZE) && LINECACHESIZE>0
+  STATECOPY(linecache);
+  STATECOPY(linecachehere);
+#endif
+#ifdef HASJUMPTABLES
+  STATECOPY(jumptables);
+  STATECOPY(jumpvalue);
+  STATECOPY(jumptarget);
+  STATECOPY(jumpentries);
+#endif
+
+  n += iocontext(p ? p + n : 0, s);
+  return n;
+}
+#undef STATECOPY
+
+/* remember the state of a fresh interpreter */
+void bcontextbegin() {
+  bcontextsize = bstate(0, 0);
+  bcontextdefault = (char*) malloc(bcontextsize);
+  if (bcontextdefault) (void) bstate(bcontextdefault, 1);
+}
+
+/* a new context with m bytes of BASIC memory */
+bcontext_t* bcontextnew(address_t m) {
+  bcontext_t* c;
+
+  if (!bcontextdefault) bcontextbegin();
+  if (!bcontextdefault || m < 128) return 0;
+  c = (bcontext_t*) malloc(sizeof(bcontext_t));
+  if (!c) return 0;
+  c->state = (char*) malloc(bcontextsize);
+  c->mem = (mem_t*) malloc(m);
+  if (!c->state || !c->mem) {
+    bcontextfree(c);
+    return 0;
+  }
+  (void) statecopy(c->state, bcontextdefault, bcontextsize, 1);
+  c->memsize = m - 1;
+  c->fresh = 1;
+  c->running = 0;
+  c->statements = 0;
+  return c;
+}
+
+/* a copy of a context with its program and its memory */
+bcontext_t* bcontextclone(bcontext_t* t) {
+  bcontext_t* c = bcontextnew(t->memsize + 1);
+
+  if (!c) return 0;
+  (void) statecopy(c->state, t->state, bcontextsize, 1);
+  (void) statecopy((char*) c->mem, t->mem, t->memsize + 1, 1);
+  c->fresh = t->fresh;
+  c->running = t->running;
+  return c;
+}
+
+void bcontextfree(bcontext_t* c) {
+  if (!c) return;
+  free(c->state);
+  free(c->mem);
+  free(c);
+}
+
+void bcontextsave(bcontext_t* c) {
+  (void) bstate(c->state, 1);
+}
+
+/* restore a context, a fresh one gets its memory and a new program */
+void bcontextrestore(bcontext_t* c) {
+  (void) bstate(c->state, 0);
+  mem = c->mem;
+  if (c->fresh) {
+    himem = memsize = c->memsize;
+    iodefaults();
+    xnew();
+    c->fresh = 0;
+  }
+}
+
+/* load a program into a context, 1 on success */
+mem_t bcontextload(bcontext_t* c, const char* f) {
+  mem_t r = 0;
+
+  bcontextrestore(c);
+  if (ifileopen(f)) {
+    xload(f);
+    r = (er == 0);
+    if (er) reseterror();
+  }
+  bcontextsave(c);
+  return r;
+}
+
+/* 
+ * run the program of a context for n statements or until it ends if n 
+ * is 0, returns 1 if the program is still running 
+ */
+mem_t bcontextrun(bcontext_t* c, unsigned long n) {
+  bcontextrestore(c);
+  if (!c->running) {
+    st = SRUN;
+    here = 0;
+    resetrunstate();
+    nexttoken();
+    c->running = 1;
+  }
+
+  bcontextbudget = n;
+  bcontextyield = 0;
+  bcontextcount = 0;
+  statement();
+  c->statements += bcontextcount;
+  bcontextbudget = 0;
+
+  if (!bcontextyield) {
+    st = SINT;
+    eflush();
+    consflush();
+    if (er) reseterror();
+    iodefaults();
+    c->running = 0;
+  }
+  bcontextsave(c);
+  return c->running;
+}
+
+/* one time slice of a context, the step function of the thread pool */
+uint8_t bcontextstep(void* c) {
+  return bcontextrun((bcontext_t*) c, CONTEXTSLICE);
+}
+#endif
+
+/*
+   The server mode, basic -s threads instances file ... loads each program 
+   once and runs the given number of instances of it on a pool of threads.
+   At the end the throughput and the CPU time of each program is reported.
+*/
+#ifdef HASSERVER
+int servermain(int argc, char** argv) {
+  int threads, instances, programs, n, i, j;
+  bcontext_t** program;
+  bcontext_t** job;
+  unsigned long* cputime;
+  unsigned long t, s, c, total = 0;
+
+  if (argc < 5) {
+    outsc("Usage: -s threads instances file ...\n");
+    return 1;
+  }
+  threads = atoi(argv[2]);
+  instances = atoi(argv[3]);
+  programs = argc - 4;
+  n = programs * instances;
+  if (threads < 1 || instances < 1) return 1;
+
+  timeinit();
+  ioinit();
+  bcontextbegin();
+  conslines = 1;
+
+  program = (bcontext_t**) malloc(programs * sizeof(bcontext_t*));
+  job = (bcontext_t**) malloc(n * sizeof(bcontext_t*));
+  cputime = (unsigned long*) malloc(n * sizeof(unsigned long));
+  if (!program || !job || !cputime) return 1;
+
+  /* tokenize each program once, the instances are copies */
+  for (i = 0; i < programs; i++) {
+    program[i] = bcontextnew(CONTEXTMEMSIZE);
+    if (!program[i] || !bcontextload(program[i], argv[4 + i])) {
+      outsc(argv[4 + i]); outspc(); printmessage(EFILE); outcr();
+      return 1;
+    }
+    for (j = 0; j < instances; j++) {
+      job[i * instances + j] = bcontextclone(program[i]);
+      if (!job[i * instances + j]) {
+        printmessage(EOUTOFMEMORY); outcr();
+        return 1;
+      }
+    }
+  }
+
+  t = millis();
+  if (!poolrun((void**) job, n, threads, bcontextstep, cputime)) return 1;
+  t = millis() - t;
+  conslines = 0;
+
+  /* the report per program and the throughput */
+  for (i = 0; i < programs; i++) {
+    s = c = 0;
+    for (j = 0; j < instances; j++) {
+      s += job[i * instances + j]->statements;
+      c += cputime[i * instances + j];
+      bcontextfree(job[i * instances + j]);
+    }
+    total += s;
+    outsc(argv[4 + i]); outsc(": ");
+    outnumber(instances); outsc(" runs, ");
+    outnumber(s); outsc(" statements, ");
+    outnumber(c / 1000); outsc(" ms CPU\n");
+    bcontextfree(program[i]);
+  }
+  outnumber(n); outsc(" runs on "); outnumber(threads); outsc(" threads in ");
+  outnumber(t); outsc(" ms, ");
+  if (t > 0) outnumber(total * 1000 / t); else outnumber(total);
+  outsc(" statements/s\n");
+  return 0;
+}
+#endif
+
 /*
  	the setup routine - Arduino style
 */
@@ -10873,6 +13712,7 @@ void setup() {
 
   /* init all io functions */
   ioinit();
+  xipbegin();
 #ifdef FILESYSTEMDRIVER
   // if (fsstat(1) == 1 && fsstat(2) > 0) outsc("Filesystem started\n");
 #endif
@@ -10954,6 +13794,11 @@ void loop() {
     st = SINT;
   }
 
+  /* the last statement of a profiled program ends here */
+#ifdef HASPROFILER
+  if (profiling) profileend();
+#endif
+
   /* always return to default io channels once interactive mode is reached */
   iodefaults();
   form = 0;
@@ -10996,6 +13841,16 @@ int main(int argc, char* argv[]) {
   bargv = argv;
 #endif
 
+  /* the state of a fresh interpreter for new contexts */
+#ifdef HASCONTEXTS
+  bcontextbegin();
+#endif
+
+  /* many programs on a pool of threads */
+#ifdef HASSERVER
+  if (argc > 1 && argv[1][0] == '-' && argv[1][1] == 's') return servermain(argc, argv);
+#endif
+
   /* do what an Arduino would do, this loops for every interactive input */
   setup();
   while (1)
@@ -31,6 +31,28 @@
 #define SBUFSIZE       	((index_t)(16*sizeof(number_t)))
 #define VARSIZE         26
 
+/* the chunk size of block copies through the memory interface */
+#define MEMBLOCKSIZE    32
+
+/* the number of jump tables in one set of the jump table cache */
+#ifndef JUMPWAYS
+#define JUMPWAYS        4
+#endif
+
+/* the number of array elements MAT processes in one block */
+#define MATBLOCKSIZE    16
+
+/* the number of bytes record I/O moves between memory and the file in one block */
+#define RECORDBLOCKSIZE 64
+
+/* the size of the file blocks MAT INPUT reads */
+#define INPUTBLOCKSIZE  128
+
+/* the number of random number streams, hardware.h can set more */
+#ifndef RNDSTREAMS
+#define RNDSTREAMS      1
+#endif
+
 /* Default sizes of arrays and strings if they are not DIMed */
 #define ARRAYSIZEDEF    10
 #define STRSIZEDEF      32
@@ -38,6 +60,13 @@
 /* the maximum name length */
 #define MAXNAME         32
 
+/* the bytes of a parameter name in a function record, fixed to index them */
+#if !defined(HASLONGNAMES) || defined(HASNAMEIDS)
+#define FNNAMESIZE      2
+#else
+#define FNNAMESIZE      (MAXNAME + 1)
+#endif
+
 /*
  * The tokens for the BASIC keywords
  *
@@ -223,6 +252,9 @@
  */
 
  #define TCAM -128
+ #define TPROFILE -129
+ #define TLOCAL -130
+ #define TMAT -131
 
 /* BASEKEYWORD is used by the lexer. From this keyword on it tries to match. */
 #define BASEKEYWORD -121
@@ -297,7 +329,10 @@
  *		1 byte or 2 bytes - no other values supported
  */
 #ifdef HASFLOAT
-#ifdef HAS64BIT
+#ifdef HASLONGDOUBLE
+typedef long double number_t;
+typedef long long wnumber_t;
+#elif defined(HAS64BIT)
 typedef double number_t;
 typedef long long wnumber_t;
 #else
@@ -362,6 +397,7 @@ typedef struct {
  *          - the length of the entire string 
  *          - the dimension of the string strdim, this is the length of the memory segment reserved for the string
  *          - the dimension of the string array, arraydim
+ *          - with a string heap the address of the slot of the string, slot
  */
 
 typedef uint16_t stringlength_t;
@@ -372,6 +408,9 @@ typedef struct {
     stringlength_t length;
     address_t strdim; 
     address_t arraydim;
+#ifdef HASSTRINGHEAP
+    address_t slot;
+#endif
 } string_t;
 
 /* 
@@ -385,7 +424,11 @@ typedef struct {
  */
 typedef struct { 
     token_t token; 
+#ifndef HASNAMEIDS
     mem_t c[MAXNAME]; 
+#else
+    mem_t c[2]; 
+#endif
     mem_t l;
 } name_t;
 
@@ -405,6 +448,34 @@ typedef struct {
     address_t size; 
 } heap_t;
 
+/* 
+ * a compiled ON or SWITCH statement, key is the location of the statement,
+ * the n values and targets start at base in the entry pool, end is the 
+ * location after the ON statement, state is 1 if compiled, -1 if not possible 
+ * and 2 while it is compiled, dense is 1 if a SWITCH table is indexed directly
+ */
+typedef struct {
+    address_t key;
+    address_t base;
+    address_t n;
+    address_t end;
+    mem_t state;
+    mem_t dense;
+} jumptable_t;
+
+/* 
+ * the call frame of a function, the parameters and locals live in the 
+ * slots base to base+n-1 and not on the heap, bind is the hash table from 
+ * their names to the slots in the function record, himem is remembered 
+ * to free the variables the function body creates 
+ */
+typedef struct {
+    address_t bind;
+    address_t himem;
+    index_t base;
+    mem_t n;
+} fnframe_t;
+
 /* 
  * a general loop time, needed for the reimplementation of all loops 
  * the loop time knows the variable of a for loop or alternatively 
@@ -463,6 +534,23 @@ typedef struct {
     mem_t active;
 } bevent_t;
 
+/* 
+ * An interpreter context is one BASIC program with its own memory and 
+ * a copy of the interpreter state. The state itself lives in thread 
+ * local variables, bcontextrestore() copies the context into them 
+ * and bcontextsave() back. A fresh context is set up on first restore.
+ * A running context is in the middle of its program, statements counts
+ * the statements it has executed.
+ */
+typedef struct {
+    mem_t* mem;
+    address_t memsize;
+    char* state;
+    mem_t fresh;
+    mem_t running;
+    unsigned long statements;
+} bcontext_t;
+
 /* 
  * Function prototypes, ordered by layers
  * HAL - hardware abstraction
@@ -505,6 +593,13 @@ address_t bmalloc(name_t*, address_t);
 address_t bfind(name_t*);
 address_t bfree(name_t*);
 address_t blength (name_t*);
+#ifdef HASSTRINGHEAP
+void strshift(address_t);
+void strcompact(address_t, string_t*);
+address_t strviewbase(string_t*);
+void strrebase(string_t*, address_t);
+void strensure(string_t*, address_t, address_t, string_t*);
+#endif
 
 /* normal variables of number_t */
 number_t getvar(name_t*);
@@ -521,11 +616,19 @@ void setstrlength(address_t, memwriter_t, stringlength_t);
 
 /* setting names */
 address_t setname_heap(address_t, name_t*);
+address_t heapnamesize(name_t*);
 address_t setname_pgm(address_t, name_t*);
 address_t getname(address_t, name_t*, memreader_t);
 mem_t cmpname(name_t*, name_t*);
 void zeroname(name_t*);
 void zeroheap(heap_t*);
+#ifdef HASNAMEIDS
+address_t poolname(mem_t*, mem_t);
+void internname(name_t*, mem_t*, mem_t);
+void clrnames();
+address_t esavenames(address_t);
+address_t eloadnames(address_t);
+#endif
 
 /* array and string handling */
 /* the multidim extension is experimental, here only 2 array dimensions implemented as test */
@@ -534,6 +637,7 @@ void array(lhsobject_t*, mem_t, number_t*);
 address_t createstring(name_t*, address_t, address_t);
 void getstring(string_t*, name_t*, address_t, address_t);
 void setstringlength(name_t*, address_t, address_t);
+void setstringbuffer(lhsobject_t*, string_t*, char*, address_t);
 
 /* the user defined extension functions */
 number_t getusrvar();
@@ -622,9 +726,13 @@ void nexttoken();
 /* storing and retrieving programs */
 char nomemory(number_t);
 void storetoken(); 
+void xipbegin();
 mem_t memread(address_t);
 mem_t memread2(address_t);
 void memwrite2(address_t, mem_t);
+void memread_block(address_t, char*, address_t);
+void memwrite_block(address_t, char*, address_t);
+void memmove_block(address_t, address_t, address_t);
 mem_t beread(address_t);
 void beupdate(address_t, mem_t);
 void gettoken();
@@ -635,6 +743,17 @@ void clrlinecache();
 void addlinecache(address_t, address_t);
 address_t findinlinecache(address_t);
 void findline(address_t);
+#ifdef HASJUMPTABLES
+void clrjumptables();
+jumptable_t* findjumptable(address_t);
+void compactjumpentries();
+mem_t addjumpentry(jumptable_t*, number_t, address_t);
+void endjumptable(jumptable_t*, mem_t);
+void makeontable(jumptable_t*);
+void makeswitchtable(jumptable_t*);
+void sortjumptable(jumptable_t*);
+address_t findjumpentry(jumptable_t*, number_t);
+#endif
 address_t myline(address_t);
 void moveblock(address_t, address_t, address_t);
 void zeroblock(address_t, address_t);
@@ -658,9 +777,25 @@ void xsgn();
 void xpeek();
 void xmap();
 number_t rnd(); 
+uint32_t rndrotl(uint32_t, mem_t);
+uint32_t rndnext();
+void rndjump();
+void rndseed(unsigned long);
+void rndselect(mem_t);
+number_t rndnumber(number_t);
 void xrnd();
 void sqr();
 void xpow();
+#ifdef HASINT64
+mem_t isint64(number_t);
+mem_t int64mulok(int64_t, int64_t);
+number_t intadd(number_t, number_t);
+number_t intsub(number_t, number_t);
+number_t intmul(number_t, number_t);
+number_t intdiv(number_t, number_t);
+number_t intmod(number_t, number_t);
+number_t intpow(number_t, number_t);
+#endif
 number_t bpow(number_t, number_t);
 
 /* string values and string evaluation */
@@ -676,6 +811,12 @@ void xatan();
 void xlog();
 void xexp();
 void xint();
+address_t matsimd(token_t, number_t*, address_t);
+void matapply(token_t, address_t, address_t, address_t);
+void matrnd(address_t, address_t, number_t);
+mem_t matinputfield(name_t*, address_t, address_t, char*, address_t);
+void xmatinput();
+void xmat();
 
 /* expression evaluation */
 void factor();
@@ -698,8 +839,10 @@ void rtcmkstr();
 /* basic commands of the core language set */
 void xprint();
 void getstringtobuffer(string_t*, char*, stringlength_t);
+void outstring(string_t*);
 void lefthandside(lhsobject_t*);
 void assignnumber(lhsobject_t, number_t);
+void assignnumber2(lhsobject_t*, number_t);
 void assignstring(string_t*, string_t*, stringlength_t);
 void assignment();
 void showprompt();
@@ -727,6 +870,7 @@ void xuntil();
 /* control commands and misc */
 void outputtoken();
 void xlist();
+void resetrunstate();
 void xrun();
 void xnew();
 void xrem();
@@ -744,6 +888,15 @@ void getfilename(char*, char);
 char* getfilename2(char);
 void xsave();
 void xload(const char*);
+mem_t recordseek(mem_t);
+mem_t recordfits(address_t);
+void recordwrite(char*, address_t);
+void recordread(char*, address_t);
+void recordwritemem(address_t, address_t);
+void recordreadmem(address_t, address_t);
+address_t recordarray(address_t*);
+void xputrecord();
+void xgetrecord();
 void xget();
 void xput();
 void xset();
@@ -801,15 +954,24 @@ void xusr();
 /* the dartmouth stuff */
 void xdata();
 void nextdatarecord();
+#ifdef HASDATAINDEX
+void makedataindex();
+#endif
 void xread();
 void xrestore();
 void xdef();
+address_t fnfind(name_t*);
+number_t* fnvariable(name_t*);
+address_t fnhash(name_t*);
+void fnpopframe();
 void xfn(mem_t);
 void xon();
 
 /* timers and interrupts */
 void xtimer();
 void resettimer(btimer_t*);
+mem_t timerdue();
+mem_t inputwait();
 
 /* structured BASIC extensions */
 void xwhile();
@@ -826,9 +988,31 @@ void xedit();
 /* camera support with a meta command */
 void xcam();
 
+/* the statement profiler */
+void profilebegin();
+void profileclear();
+index_t profileindex(address_t);
+void profilestatement();
+void profileend();
+void profileswitch(mem_t);
+void xprofile();
+
 /* the statement loop */
 void statement();
 
+/* interpreter contexts */
+long bstate(char*, mem_t);
+void bcontextbegin();
+bcontext_t* bcontextnew(address_t);
+bcontext_t* bcontextclone(bcontext_t*);
+void bcontextfree(bcontext_t*);
+void bcontextsave(bcontext_t*);
+void bcontextrestore(bcontext_t*);
+mem_t bcontextload(bcontext_t*, const char*);
+mem_t bcontextrun(bcontext_t*, unsigned long);
+uint8_t bcontextstep(void*);
+int servermain(int, char**);
+
 /* the extension functions */
 void bsetup();
 void bloop();
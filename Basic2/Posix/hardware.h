@@ -45,12 +45,24 @@
  * POSIXSIGNALS: enables signal handling of ^C interrupting programs
  * POSIXNONBLOCKING: non blocking I/O to handle GET and the BREAKCHAR 
  *  tricky on DOS, not very portable, experimental, use signals instead
+ * POSIXEVENTLOOP: poll() the console and the printer port into ring buffers,
+ *  replaces POSIXNONBLOCKING, timers keep running while INPUT waits
  * POSIXFRAMEBUFFER: directly draw to the frame buffer of Raspberry PI
  *  only tested on this platform
  * POSIXWIRE: simple Raspberry PI wire code
- * POSIXMQTT: analogous to ARDUINOMQTT, send and receive MQTT messages (unfinished)
+ * POSIXMQTT: analogous to ARDUINOMQTT, send and receive MQTT messages, a small
+ *  MQTT 3.1.1 client on plain sockets, connects to the broker set below
  * POSIXWIRING: use the (deprectated) wiring code for gpio on Raspberry Pi
  * POSIXPIGPIO: use the pigpio library on a Raspberry PI  - currently broken - wire change - don't use
+ * POSIXEEPROMMMAP: map eeprom.dat into memory and write back only changed pages
+ * POSIXCONTEXTS: the interpreter state is thread local, it can be saved 
+ *  to and restored from a context, many BASIC programs run in one process
+ * POSIXSERVER: with POSIXCONTEXTS, basic -s runs many programs on a pool 
+ *  of threads
+ * POSIXDISPLAY: a headless in-memory text display running the display driver 
+ *  and vt52 code of the Arduino platforms, for tests and benchmarks, replaces
+ *  POSIXVT52TOANSI and POSIXFRAMEBUFFER. Off unless defined here or with 
+ *  -DPOSIXDISPLAY on the command line.
  * ESP32CAMERA: a stub to help with development of the MCU code
  */
 
@@ -58,15 +70,21 @@
 #define POSIXVT52TOANSI
 #define POSIXSIGNALS
 #undef POSIXNONBLOCKING
+#define POSIXEVENTLOOP
 #undef POSIXFRAMEBUFFER
 #undef POSIXWIRE
 #undef POSIXMQTT
 #undef POSIXWIRING
 #undef POSIXPIGPIO
+#define POSIXEEPROMMMAP
+#define POSIXCONTEXTS
+#define POSIXSERVER
 #define ESP32CAMERA
 
-/* simulates SPI RAM, only test code, keep undefed if you don't want to do something special */
-#undef SPIRAMSIMULATOR
+/* 
+ * simulates SPI RAM, only test code, off unless defined here or with 
+ * -DSPIRAMSIMULATOR on the command line 
+ */
 
 #ifdef SPIRAMSIMULATOR
 #define USEMEMINTERFACE
@@ -117,17 +135,99 @@
 #define BASICBGTASK
 #endif
 
-/* frame buffer health check - currently only supported on Raspberry */ 
-#ifndef RASPPI
+/* frame buffer health check - the code needs the linux framebuffer headers */ 
+#ifndef __linux__
 #undef POSIXFRAMEBUFFER
 #endif
 
+/* size of the back buffer if there is no /dev/fb0 and the PPM dump file */
+#define FRAMEWIDTH 640
+#define FRAMEHEIGHT 480
+#define FRAMEDUMPFILE "framebuffer.ppm"
+
+/* the headless display brings its own vt52 engine and is text only */
+#ifdef POSIXDISPLAY
+#undef POSIXVT52TOANSI
+#undef POSIXFRAMEBUFFER
+#define DISPLAYDRIVER
+#define DISPLAYCANSCROLL
+#define HASVT52
+#define POSIXDISPLAYROWS 24
+#define POSIXDISPLAYCOLUMNS 80
+#endif
+
 /* wire parameters for Raspberry*/
 #define POSIXI2CBUS 1
 
 /* the size of the EEPROM dummy */
 #define EEPROMSIZE 1024
 
+/* no mmap and no poll on DOS and Windows */
+#if defined(MSDOS) || defined(MINGW)
+#undef POSIXEEPROMMMAP
+#undef POSIXEVENTLOOP
+#undef POSIXMQTT
+#undef POSIXCONTEXTS
+#undef POSIXSERVER
+#endif
+
+/* 
+ * with contexts all variables of the interpreter state are 
+ * thread local, BSTATE marks them in basic.c and runtime.c
+ */
+#ifdef POSIXCONTEXTS
+#define HASCONTEXTS
+#define BSTATE __thread
+#else
+#define BSTATE
+#endif
+
+/* 
+ * the server mode, basic -s threads instances files runs instances of 
+ * programs on a pool of threads, CONTEXTMEMSIZE is the memory of one 
+ * instance, CONTEXTSLICE the number of statements before it yields,
+ * CONSLINESIZE the size of the console line buffer of an instance
+ */
+#if defined(POSIXSERVER) && defined(POSIXCONTEXTS)
+#define HASSERVER
+#define CONTEXTMEMSIZE 32768
+#define CONTEXTSLICE 1000
+#define CONSLINESIZE 128
+#endif
+
+/* the size of the input ring buffers of the event loop */
+#define IORINGSIZE 1024
+
+/* the output buffer of the printer port */
+#define PRTBUFSIZE 256
+
+/* 
+ * the MQTT broker and the client parameters, compiled in like 
+ * wifisettings.h on the Arduino platforms
+ * MQTTQUEUESIZE is the number of inbound messages held, MQTTINFLIGHT
+ * the number of QoS 1 messages waiting for their PUBACK, MQTTSBUFSIZE 
+ * the socket buffer batching outgoing packets
+ */
+#ifdef POSIXMQTT
+#define MQTTSERVER "localhost"
+#define MQTTPORT 1883
+#define MQTTUSER ""
+#define MQTTPASSWD ""
+#define MQTTKEEPALIVE 60
+#define MQTTQUEUESIZE 32
+#define MQTTINFLIGHT 16
+#define MQTTSBUFSIZE 4096
+#define MQTTRBUFSIZE 4096
+#define MQTTFLUSHINTERVAL 5
+#define MQTTTIMEOUT 2000
+#endif
+
+/* the event loop replaces the non blocking code and lets INPUT wait for timers */
+#ifdef POSIXEVENTLOOP
+#undef POSIXNONBLOCKING
+#define HASINPUTEVENTS
+#endif
+
 /* they all have this */
 #define FILESYSTEMDRIVER
 
@@ -160,13 +260,19 @@ typedef signed char int8_t;
 typedef unsigned short uint16_t;
 typedef signed short int16_t;
 typedef unsigned char byte;
+/* the socket headers of MQTT bring stdint.h and its uint64_t */
+#ifdef POSIXMQTT
+#include <stdint.h>
+#else
 typedef unsigned long long uint64_t;
+#endif
 typedef unsigned int uint32_t;
 
 /*
  * additional prototypes in an non Arduino world 
  */
 unsigned long millis();
+unsigned long micros();
 
 /* the ususal suspects */
 #include <stdio.h>
@@ -180,6 +286,9 @@ unsigned long millis();
 #include <time.h>
 #include <sys/types.h>
 #include <sys/timeb.h>
+#ifndef MSDOS
+#include <sys/time.h>
+#endif
 
 /* directories and files */
 #ifndef MSDOS
@@ -190,6 +299,13 @@ unsigned long millis();
 #include <dos.h>
 #endif
 
+/* the memory mapped EEPROM file */
+#ifdef POSIXEEPROMMMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
 /* windowy things for windows */
 #ifdef MINGW
 #include <windows.h>
@@ -227,13 +343,13 @@ unsigned long millis();
 /* and we use the buffer sizes for real computers */
 #if MEMSIZE == 0 || MEMSIZE < 2560000
 #define BUFSIZE         256
-#define STACKSIZE       256
+#define STACKSIZE       1024
 #define GOSUBDEPTH      64
 #define FORDEPTH        64
 #define LINECACHESIZE   64
 #else
 #define BUFSIZE         256
-#define STACKSIZE       256
+#define STACKSIZE       1024
 #define GOSUBDEPTH      196
 #define FORDEPTH        196
 #define LINECACHESIZE   196
@@ -242,11 +358,91 @@ unsigned long millis();
 /* the buffer size for simulated serial RAM */
 #define SPIRAMSBSIZE 512
 
+/* 
+ * The page cache of the serial RAM, SPIRAMSETS sets of SPIRAMWAYS pages 
+ * with SPIRAMPAGESIZE bytes each. SPIRAMPREFETCH reads the next page of 
+ * the program with a sequential token read. The simulator counts the SPI 
+ * transactions and bytes and estimates the bus time from the SPI clock in 
+ * MHz and the overhead of a transaction in us. 
+ */
+#ifdef SPIRAMSIMULATOR
+#define SPIRAMPAGESIZE 32
+#define SPIRAMWAYS 4
+#define SPIRAMSETS 8
+#define SPIRAMPREFETCH
+#define SPIRAMCLOCK 8
+#define SPIRAMOVERHEAD 2
+#endif
+
 /* 
  * This code measures the fast ticker frequency. 
  */
 #define FASTTICKERPROFILE
 
+/*
+ * The statement profiler, switched on at runtime with SET 25,1.
+ * PROFILERSIZE is the number of program lines it can keep track of.
+ * Statements in the lines after them are counted together.
+ */
+#define HASPROFILER
+#ifndef PROFILERSIZE
+#define PROFILERSIZE 8192
+#endif
+
+/*
+ * Long names are interned into two byte ids in the program and on the heap.
+ * NAMEPOOLSIZE is the number of bytes for the names, at most 32768.
+ */
+#define HASNAMEIDS
+#define NAMEPOOLSIZE 4096
+
+/*
+ * MAT B = SIN(A) applies a maths function to all elements of an array.
+ */
+#define HASARRAYMATH
+
+/*
+ * The number of independent random number streams, selected with SET 27,n.
+ */
+#define RNDSTREAMS 16
+
+/*
+ * GET #r and PUT #r read and write binary records of files opened 
+ * with OPEN "file", 3, recordsize.
+ */
+#define HASRECORDIO
+
+/*
+ * MAT INPUT A reads a file with comma separated values into an array.
+ */
+#define HASMATINPUT
+
+/*
+ * Strings grow with their content in a string heap below the variables.
+ * DIM then only sets the number of elements of a string array. The heap
+ * is compacted when it runs out of memory. Off by default as it changes
+ * the memory layout of strings, STRINGHEAPSLACK is the number of bytes
+ * a string is given on top of its length when it grows.
+ */
+#undef HASSTRINGHEAP
+#define STRINGHEAPSLACK 8
+
+/*
+ * READ uses an index of all DATA items built at the first READ of a run.
+ * DATAINDEXSIZE is the number of items, larger programs fall back to scanning.
+ */
+#define HASDATAINDEX
+#define DATAINDEXSIZE 4096
+
+/*
+ * ON GOTO/GOSUB and SWITCH with constant targets and labels are compiled
+ * to jump tables. JUMPTABLES tables with together JUMPENTRIES entries,
+ * JUMPTABLES is a multiple of the 4 tables of a cache set.
+ */
+#define HASJUMPTABLES
+#define JUMPTABLES 256
+#define JUMPENTRIES 4096
+
 /*
  * Does the platform has command line args and do we want to use them 
  */
@@ -256,7 +452,14 @@ unsigned long millis();
  * How restrictive are we on function recursive calls to protect the stack
  * On Posix systems we can be more generous.
  */
-#define FNLIMIT 128
+#define FNLIMIT 1024
+
+/*
+ * FNVARS is the number of parameters and LOCAL variables of one function,
+ * FNSLOTS the number of these variables in all active frames together.
+ */
+#define FNVARS 16
+#define FNSLOTS 4096
 
 /* all POSIXish systems can do the full interpreter, only here for compatibility with Arduino */
 #define BASICFULL
@@ -87,6 +87,8 @@
  * 	are valid number input with it. Default now but can have odd side effects.
  * HASLONGNAMES: long variable names, up to 16 characters. Name length is set by MAXNAME in basic.h and
  * 	can be any value <128 bytes. Names are still only uppercase and all names will be uppercased by lexer.
+ * HASNAMEIDS: names longer than two characters are interned into a name pool by the lexer. Program 
+ * 	and heap only store two byte ids then. Set in hardware.h.
  * HASHELP: show the commands of the interpreter. Will be extended to a help system.
  * HASFULLINSTR: the full C64 style INSTR command. Without this flag INSTR only accepts
  *	a single character as argument. This is much faster and leaner on an Arduino. 
@@ -159,6 +161,15 @@
  *  HAS64BIT: 64 bit floating point support on platforms that have a 64 bit double. 
  *      Counterexample: AVR 8bit does not have 64 bit floating point.
  * HAS32BITINT: 32 bit integer support on 8 bit platforms.
+ * HASLONGDOUBLE: long double floating point on platforms that have it. Only where 
+ *      long double has a 64 bit mantissa, like gcc and clang on x86, it holds all 
+ *      64 bit integers exactly. With MSVC and on ARM long double is often just a 
+ *      double and nothing is gained. 
+ * HASINT64: the mixed integer mode. Integer operands of + - * / % and ^ are 
+ *      computed as int64 and the results are exact. If the result overflows it 
+ *      is promoted to a long double floating point number. Needs HASLONGDOUBLE 
+ *      with a 64 bit mantissa, compiling fails otherwise. Off unless defined 
+ *      here or with -DHASINT64 on the command line.
  * HASPOWER: the POWER operator ^ is available in addition to the POW function.
  * HASUSRCALL: the USR and CALL functions. On small systems they need a lot 
  *      of flash and can be disabled.
@@ -171,6 +182,7 @@
 #define BOOLEANMODE -1
 #undef  HAS64BIT
 #undef  HAS32BITINT
+#undef  HASLONGDOUBLE
 #define HASPOWER 
 #define HASUSRCALL
 
@@ -466,12 +478,69 @@
 #define HASFULLINSTR
 #endif
 
+/* the mixed integer mode carries its integers in long doubles */
+#if defined(HASINT64) && defined(HASFLOAT)
+#define HASLONGDOUBLE
+#else
+#undef HASINT64
+#endif
+
+/* long doubles are only used as floating point type */
+#if defined(HASLONGDOUBLE) && !defined(HASFLOAT)
+#undef HASLONGDOUBLE
+#endif
+
 /* dependencies on the hardware */
 #if !defined(DISPLAYHASGRAPH) 
 #undef HASGRAPH
 #endif
 
-/* the camera sits in the long token space */
-#if defined(HASCAMERA)
+/* name ids only make sense with long names */
+#if defined(HASNAMEIDS) && !defined(HASLONGNAMES)
+#undef HASNAMEIDS
+#endif
+
+/* the DATA index is only needed with READ and DATA */
+#if defined(HASDATAINDEX) && !defined(HASDARTMOUTH)
+#undef HASDATAINDEX
+#endif
+
+/* INPUT only waits for timers if there are timers */
+#if defined(HASINPUTEVENTS) && !defined(HASTIMER)
+#undef HASINPUTEVENTS
+#endif
+
+/* the server mode gets its programs from the command line */
+#if defined(HASSERVER) && !defined(HASARGS)
+#undef HASSERVER
+#endif
+
+/* the profiler is controlled by SET and needs the stefans extensions */
+#if defined(HASPROFILER) && !defined(HASSTEFANSEXT)
+#undef HASPROFILER
+#endif
+
+/* the string heap needs the heap and keeps to RAM */
+#if defined(HASSTRINGHEAP) && (!defined(HASAPPLE1) || defined(EEPROMMEMINTERFACE))
+#undef HASSTRINGHEAP
+#endif
+
+/* MAT works on the arrays of the heap with the floating point functions */
+#if defined(HASARRAYMATH) && (!defined(HASFLOAT) || !defined(HASAPPLE1))
+#undef HASARRAYMATH
+#endif
+
+/* MAT INPUT is part of MAT and reads files */
+#if defined(HASMATINPUT) && (!defined(HASARRAYMATH) || !defined(FILESYSTEMDRIVER))
+#undef HASMATINPUT
+#endif
+
+/* binary records need a file system with positioning */
+#if defined(HASRECORDIO) && !defined(FILESYSTEMDRIVER)
+#undef HASRECORDIO
+#endif
+
+/* the camera, the profiler, LOCAL and MAT sit in the long token space */
+#if defined(HASCAMERA) || defined(HASPROFILER) || defined(HASMULTILINEFUNCTIONS) || defined(HASARRAYMATH)
 #define HASLONGTOKENS
 #endif
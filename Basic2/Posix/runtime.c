@@ -38,19 +38,19 @@ void bloop() {}
  *  Global variables of the runtime env.
  */
 
-int8_t id; // active input stream 
-int8_t od; // active output stream 
-int8_t idd = ISERIAL; // default input stream in interactive mode 
-int8_t odd = OSERIAL; // default output stream in interactive mode 
-int8_t ioer = 0; // the io error variable, always or-ed with ert in BASIC
+BSTATE int8_t id; // active input stream 
+BSTATE int8_t od; // active output stream 
+BSTATE int8_t idd = ISERIAL; // default input stream in interactive mode 
+BSTATE int8_t odd = OSERIAL; // default output stream in interactive mode 
+BSTATE int8_t ioer = 0; // the io error variable, always or-ed with ert in BASIC
 
 /* counts the outputed characters on streams 0-3, used to emulate a real tab */
 #ifdef HASMSTAB
-uint8_t charcount[5]; /* devices 1-4 support tabing */
+BSTATE uint8_t charcount[5]; /* devices 1-4 support tabing */
 #endif
 
-/* the pointer to the buffer used for the &0 device */
-char* nullbuffer = ibuffer;
+/* the pointer to the buffer used for the &0 device, the input buffer of the thread if 0 */
+BSTATE char* nullbuffer = 0;
 uint16_t nullbufsize = BUFSIZE; 
 uint8_t bufferstat(uint8_t c) { return 1; }
 
@@ -95,8 +95,28 @@ int pigpio_pi = 0;
  */
 const uint16_t serial_baudrate = 0;
 const uint16_t serial1_baudrate = 0;
-uint8_t sendcr = 0;
-uint8_t blockmode = 0;
+BSTATE uint8_t sendcr = 0;
+BSTATE uint8_t blockmode = 0;
+
+/* 
+ * in server mode many threads write to the console, each interpreter 
+ * collects its output in a line and writes it at once with consflush()
+ */
+#ifdef HASSERVER
+uint8_t conslines = 0;
+BSTATE char consline[CONSLINESIZE];
+BSTATE uint16_t conslinen = 0;
+
+void consflush() {
+  if (conslinen) {
+    fwrite(consline, 1, conslinen, stdout);
+    fflush(stdout);
+    conslinen = 0;
+  }
+}
+#else
+void consflush() {}
+#endif
 
 /* 
  *  Input and output functions.
@@ -422,6 +442,7 @@ uint16_t consins(char *b, uint16_t nb) {
   char c;
   uint16_t z;
 
+  consflush();
   z=1;
   while(z < nb) {
     c=inch();
@@ -649,7 +670,13 @@ long freeRam() {
 /* 
  * the sleep and restart functions
  */
-void restartsystem() { exit(0);}
+void restartsystem() { 
+  prtflush();
+#ifdef POSIXMQTT
+  netstop();
+#endif
+  exit(0);
+}
 void activatesleep(long t) {}
 
 /* 
@@ -674,9 +701,12 @@ void spibegin() {}
  * 
  * Color is currently either 24 bit or 4 bit 16 color vga.
  */
+#ifndef POSIXDISPLAY
 const int dsp_rows=0;
 const int dsp_columns=0;
+#ifndef POSIXFRAMEBUFFER
 void dspsetupdatemode(uint8_t c) {}
+#endif
 void dspwrite(char c){}
 void dspbegin() {}
 uint8_t dspstat(uint8_t c) {return 0; }
@@ -684,6 +714,525 @@ char dspwaitonscroll() { return 0; }
 uint8_t dspactive() {return 0; }
 void dspsetscrollmode(uint8_t c, uint8_t l) {}
 void dspsetcursor(uint8_t c) {}
+#else
+/*
+ * The headless display, an in-memory text display of POSIXDISPLAYROWS
+ * x POSIXDISPLAYCOLUMNS running the generic display driver and the 
+ * vt52 state engine of the Arduino code. Nothing is shown, dspprintchar()
+ * only counts the characters a real display would have to draw. 
+ *
+ * The display buffer is a ring of rows. A scroll of the entire screen 
+ * moves the start of the ring and clears the new rows instead of 
+ * copying all rows. This is what a display with hardware scrolling 
+ * would do. Partial scrolls for insert and delete line copy the rows.
+ *
+ * USR(2, 1) is the number of characters drawn, USR(2, 2) the number 
+ * of rows scrolled.
+ */
+const int dsp_rows=POSIXDISPLAYROWS;
+const int dsp_columns=POSIXDISPLAYCOLUMNS;
+
+/* the counters */
+unsigned long dspcharsdrawn = 0;
+unsigned long dsprowsscrolled = 0;
+
+/* the hardware part, only counting */
+void dspbegin() { dspsetscrollmode(0, 1); }
+void dspprintchar(char c, uint8_t col, uint8_t row) { if (c) dspcharsdrawn++; }
+void dspclear() {}
+void dspupdate() {}
+void dspsetcursor(uint8_t c) {}
+void dspsetfgcolor(uint8_t c) {}
+void dspsetbgcolor(uint8_t c) {}
+void dspsetreverse(uint8_t c) {}
+uint8_t dspident() { return 0; }
+
+/* the counters for USR(2, i) */
+unsigned long dspcounter(uint8_t i) {
+  switch (i) {
+  case 1: 
+    return dspcharsdrawn;
+  case 2:
+    return dsprowsscrolled;
+  default:
+    return 0;
+  }
+}
+
+/* the cursor position */
+uint8_t dspmycol = 0;
+uint8_t dspmyrow = 0;
+
+/* the escape state of the vt52 terminal */
+uint8_t dspesc = 0;
+
+/* which update mode do we have */
+uint8_t dspupdatemode = 0;
+
+/* how do we handle wrap 0 is wrap, 1 is no wrap */
+uint8_t dspwrap = 0; 
+
+/* the print mode */
+uint8_t dspprintmode = 0;
+
+/* the scroll control variables */
+uint8_t dspscrollmode = 0;
+uint8_t dsp_scroll_rows = 1;
+
+uint8_t dspstat(uint8_t c) { return 1; }
+
+void dspsetcursorx(uint8_t c) {
+  if (c<dsp_columns) dspmycol=c;
+  dspprintchar(0, dspmycol, dspmyrow);
+}
+
+void dspsetcursory(uint8_t r) {
+  if (r<dsp_rows) dspmyrow=r;
+  dspprintchar(0, dspmycol, dspmyrow);
+}
+
+uint8_t dspgetcursorx() { return dspmycol; }
+
+uint8_t dspgetcursory() { return dspmyrow; }
+
+uint8_t dspactive() {
+  return od == ODSP;
+}
+
+/* to whom the bell tolls - implement this to you own liking */
+void dspbell() {}
+
+/* the update modes, only for compatibility here */
+void dspsetupdatemode(uint8_t c) {
+  dspupdatemode=c;
+}
+
+uint8_t dspgetupdatemode() {
+  return dspupdatemode;
+}
+
+void dspgraphupdate() {
+  if (dspupdatemode == 0) dspupdate();
+}
+
+/* the display buffer and the ring index of the top row */
+dspbuffer_t dspbuffer[POSIXDISPLAYROWS*POSIXDISPLAYCOLUMNS];
+int dsptoprow = 0;
+
+/* the start of row r in the ring */
+dspbuffer_t* dsprow(uint8_t r) {
+  return dspbuffer + ((dsptoprow + r) % dsp_rows) * dsp_columns;
+}
+
+/* needed for @D() */
+dspbuffer_t dspget(uint16_t i) {
+  if (i<=dsp_columns*dsp_rows-1) return dsprow(i/dsp_columns)[i%dsp_columns]; else return 0;
+}
+
+/* print line and screen helpers */
+dspbuffer_t dspgetrc(uint8_t r, uint8_t c) { return dsprow(r)[c]; }
+dspbuffer_t dspgetc(uint8_t c) { return dsprow(dspmyrow)[c]; }
+
+/* this functions prints a character and updates the display buffer */
+void dspsetxy(dspbuffer_t ch, uint8_t c, uint8_t r) {
+  if (r<dsp_rows && c<dsp_columns) {
+    dsprow(r)[c]=ch;
+    if (ch != 0) dspprintchar(ch, c, r); else dspprintchar(' ', c, r);
+  }
+}
+
+/* needed for @D() access */
+void dspset(uint16_t i, dspbuffer_t ch) {
+  uint8_t c=i%dsp_columns;
+  uint8_t r=i/dsp_columns;
+  dspsetxy(ch, c, r);
+}
+
+/* 0 normal scroll, 1 enable waitonscroll function */
+void dspsetscrollmode(uint8_t c, uint8_t l) {
+  dspscrollmode = c;
+  dsp_scroll_rows = l;
+}
+
+/* clear the buffer */
+void dspbufferclear() {
+  int i;
+
+  for (i=0; i<dsp_rows*dsp_columns; i++) dspbuffer[i]=0;
+  dsptoprow=0;
+  dspmyrow=0;
+  dspmycol=0;
+}
+
+/* clear one row, blanks on the display are only drawn where something was */
+void dspclearrow(uint8_t r) {
+  uint8_t c;
+  dspbuffer_t* p = dsprow(r);
+
+  for (c=0; c<dsp_columns; c++) {
+    if (p[c] != 0 && p[c] != 32) dspprintchar(' ', c, r);
+    p[c]=0;
+  }
+}
+
+/* copy row s to row r and draw the characters that change */
+void dspcopyrow(uint8_t r, uint8_t s) {
+  uint8_t c;
+  dspbuffer_t* a = dsprow(r);
+  dspbuffer_t* b = dsprow(s);
+
+  for (c=0; c<dsp_columns; c++) {
+    if (a[c] != b[c]) dspprintchar(b[c] ? b[c] : ' ', c, r);
+    a[c]=b[c];
+  }
+}
+
+/* do the scroll, the entire screen only moves the ring */
+void dspscroll(uint8_t scroll_rows, uint8_t scroll_top){
+  uint8_t r;
+
+  if (scroll_rows > dsp_rows) scroll_rows=dsp_rows;
+
+  if (scroll_top == 0) {
+    dsptoprow=(dsptoprow + scroll_rows) % dsp_rows;
+    for (r=dsp_rows-scroll_rows; r<dsp_rows; r++) dspclearrow(r);
+  } else {
+    for (r=scroll_top; r<dsp_rows-scroll_rows; r++) dspcopyrow(r, r+scroll_rows);
+    for (r=dsp_rows-scroll_rows; r<dsp_rows; r++) dspclearrow(r);
+  }
+  dsprowsscrolled+=scroll_rows;
+
+/* set the cursor to the first free line	*/ 
+  dspmycol=0;
+  dspmyrow=dsp_rows-scroll_rows;
+}
+
+/* do the reverse scroll only one line implemented */
+void dspreversescroll(uint8_t line){
+  uint8_t r;
+
+  if (line == 0) {
+    dsptoprow=(dsptoprow + dsp_rows - 1) % dsp_rows;
+  } else {
+    for (r=dsp_rows-1; r>line; r--) dspcopyrow(r, r-1);
+  }
+  dspclearrow(line);
+  dsprowsscrolled++;
+
+/* set the cursor to the free line  */ 
+  dspmyrow=line;
+}
+
+/* again a break in API, using inch here */
+char dspwaitonscroll() {
+  char c;
+
+  if ( dspscrollmode == 1 ) {
+    if (dspmyrow == dsp_rows-1) {
+      c=inch();
+      if (c == ' ') dspwrite(12);
+      return c;
+    }
+  }
+  return 0;
+}
+
+/* 
+ * This is the minimalistic VT52 state engine. It is an interface to 
+ * process single byte control sequences of the form <ESC> char 
+ */
+
+/* the state variable */
+char vt52s = 0;
+
+/* the graphics mode mode - unused so far */
+uint8_t vt52graph = 0;
+
+/* the secondary cursor */
+uint8_t vt52mycol = 0;
+uint8_t vt52myrow = 0;
+
+/* temp variables for column and row */
+uint8_t vt52tmpr;
+uint8_t vt52tmpc;
+
+/* an output buffer for the vt52 terminal */
+#define VT52BUFFERSIZE 4
+char vt52outbuffer[VT52BUFFERSIZE] = { 0, 0, 0, 0 };
+uint8_t vt52bi = 0;
+uint8_t vt52bj = 0;
+
+/* the reader from the buffer */
+char vt52read() {
+  if (vt52bi<=vt52bj) { vt52bi = 0; vt52bj = 0; } /* empty, reset */
+  if (vt52bi>vt52bj) return vt52outbuffer[vt52bj++];
+  return 0;
+}
+
+/* the avail from the buffer */
+uint8_t vt52avail() { if (vt52bi > vt52bj) return vt52bi-vt52bj; else return 0; }
+
+/* putting something into the buffer */
+void vt52push(char c) {
+  if (vt52bi < VT52BUFFERSIZE) vt52outbuffer[vt52bi++]=c; 
+}
+
+/* clear the buffer */
+void vt52clear() {
+  vt52bi=0;
+}
+
+/* something little */
+uint8_t vt52number(char c) {
+  uint8_t b=c;
+  if (b>31) return b-32; else return 0;
+}
+
+/* the actual vt52 state engine */
+void dspvt52(char* c){
+  int i;
+  
+/* reading and processing multi byte commands */
+  switch (vt52s) {
+    case 'Y':
+      if (dspesc == 2) { 
+        dspsetcursory(vt52number(*c));
+        dspesc=1; 
+        *c=0;
+        return;
+      }
+      if (dspesc == 1) { 
+        dspsetcursorx(vt52number(*c)); 
+        *c=0; 
+      }
+      vt52s=0; 
+      break;
+    case 'b':
+      dspsetfgcolor(vt52number(*c));
+      *c=0;
+      vt52s=0;
+      break;
+    case 'c':
+      dspsetbgcolor(vt52number(*c));
+      *c=0;
+      vt52s=0;
+      break;
+  }
+ 
+/* commands of the terminal in text mode */
+  switch (*c) {
+    case 'v': /* GEMDOS / TOS extension enable wrap */
+      dspwrap=0;
+      break;
+    case 'w': /* GEMDOS / TOS extension disable wrap */
+      dspwrap=1;
+      break;
+    case '^': /* Printer extensions - print on */
+      dspprintmode=1;
+      break;
+    case '_': /* Printer extensions - print off */
+      dspprintmode=0;
+      break;
+    case 'W': /* Printer extensions - print without display on */
+      dspprintmode=2;
+      break;
+    case 'X': /* Printer extensions - print without display off */
+      dspprintmode=0;
+      break;
+    case 'V': /* Printer extensions - print cursor line */
+#ifdef POSIXPRT
+      for (i=0; i<dsp_columns; i++) prtwrite(dspgetc(i));
+#endif
+      break;
+    case ']': /* Printer extension - print screen */
+#ifdef POSIXPRT
+      for (i=0; i<dsp_rows*dsp_columns; i++) prtwrite(dspget(i));
+#endif
+      break;
+    case 'F': /* enter graphics mode */
+      vt52graph=1;
+      break;
+    case 'G': /* exit graphics mode */
+      vt52graph=0;
+      break;
+    case 'Z': /* Ident */
+      vt52clear();
+      vt52push(27);
+      vt52push('/');
+#ifndef POSIXPRT
+      vt52push('K');
+#else
+      vt52push('L');
+#endif
+      break;
+    case '=': /* alternate keypad on */
+    case '>': /* alternate keypad off */
+      break;
+    case 'b': /* GEMDOS / TOS extension text color */
+    case 'c': /* GEMDOS / TOS extension background color */
+      vt52s=*c;
+      dspesc=1;
+      *c=0;
+      return;
+    case 'e': /* GEMDOS / TOS extension enable cursor */
+      dspsetcursor(1);
+      break;
+    case 'f': /* GEMDOS / TOS extension disable cursor */
+      dspsetcursor(0);
+      break;
+    case 'p': /* GEMDOS / TOS extension reverse video */
+      dspsetreverse(1);
+      break;
+    case 'q': /* GEMDOS / TOS extension normal video */
+      dspsetreverse(0);
+      break;
+    case 'A': /* cursor up */
+      if (dspmyrow>0) dspmyrow--;
+      break;
+    case 'B': /* cursor down */
+      if (dspmyrow < dsp_rows-1) dspmyrow++;
+      break;
+    case 'C': /* cursor right */
+      if (dspmycol < dsp_columns-1) dspmycol++;
+      break; 
+    case 'D': /* cursor left */
+      if (dspmycol>0) dspmycol--;
+      break;
+    case 'E': /* GEMDOS / TOS extension clear screen */
+      dspbufferclear();
+      dspclear();
+      break;
+    case 'H': /* cursor home */
+      dspmyrow=dspmycol=0;
+      break;  
+    case 'Y': /* Set cursor position */
+      vt52s='Y';
+      dspesc=2;
+      *c=0;
+      return;
+    case 'J': /* clear to end of screen */
+      for (i=dspmycol+dsp_columns*dspmyrow; i<dsp_columns*dsp_rows; i++) dspset(i, 0);
+      break;
+    case 'd': /* GEMDOS / TOS extension clear to start of screen */
+      for (i=0; i<dspmycol+dsp_columns*dspmyrow; i++) dspset(i, 0);
+      break;
+    case 'K': /* clear to the end of line */
+      for (i=dspmycol; i<dsp_columns; i++) dspsetxy(0, i, dspmyrow);
+      break;
+    case 'l': /* GEMDOS / TOS extension clear line */
+      for (i=0; i<dsp_columns; i++) dspsetxy(0, i, dspmyrow);
+      break;
+    case 'o': /* GEMDOS / TOS extension clear to start of line */
+      for (i=0; i<=dspmycol; i++) dspsetxy(0, i, dspmyrow);
+      break;
+    case 'k': /* GEMDOS / TOS extension restore cursor */
+      dspmycol=vt52mycol;
+      dspmyrow=vt52myrow;
+      break;
+    case 'j': /* GEMDOS / TOS extension save cursor */
+      vt52mycol=dspmycol;
+      vt52myrow=dspmyrow;
+      break;
+    case 'I': /* reverse line feed */
+      if (dspmyrow>0) dspmyrow--; else dspreversescroll(0);
+      break;
+    case 'L': /* Insert line */
+      dspreversescroll(dspmyrow);
+      break;
+    case 'M': /* Delete line */
+      vt52tmpr = dspmyrow;
+      vt52tmpc = dspmycol;
+      dspscroll(1, dspmyrow);
+      dspmyrow=vt52tmpr;
+      dspmycol=vt52tmpc;
+      break;
+  }
+  dspesc=0;
+  *c=0;
+}
+
+/* the generic write function */
+void dspwrite(char c){
+  int8_t dspmycolt;
+
+/* on escape call the vt52 state engine, it modifies the character */
+  if (dspesc) dspvt52(&c); 
+
+/* do we print? */
+#ifdef POSIXPRT
+  if (dspprintmode) {
+    prtwrite(c);
+    if (sendcr && c == 10) prtwrite(13); /* some printers want cr */
+    if (dspprintmode == 2) return; /* do not print in mode 2 */
+  }
+#endif 
+  
+/* the buildin control characters for all displays */
+  switch(c) {
+    case 0:
+      return;
+    case 7: /* the function dspbell() is not implemented */
+      dspbell();
+      return;
+    case 9: /* tab moves on 8 positions */
+      dspmycolt = dspmycol/8;
+      if ((dspmycolt+1)*8<dsp_columns-1) dspmycol=(dspmycolt+1)*8;
+      return;
+    case 10: /* this is LF Unix style doing also a CR */
+      dspmyrow++;
+      if (dspmyrow >= dsp_rows) dspscroll(dsp_scroll_rows, 0);  
+      dspmycol=0;
+      if (dspupdatemode == 1) dspupdate();
+      return;
+    case 11: /* vertical tab - converted to line feed without carriage return */
+      if (dspmyrow < dsp_rows-1) dspmyrow++;
+      return; 
+    case 12: /* form feed is clear screen plus home */
+      dspbufferclear();
+      dspclear();
+      return;
+    case 13: /* classical carriage return, no form feed */
+      dspmycol=0;
+      return;
+    case 27: /* escape - initiate vtxxx mode */
+      dspesc=1;
+      return;
+    case 28: /* cursor back - this is what terminal applications send for cursor back */
+      if (dspmycol > 0) dspmycol--;
+      return;
+    case 29: /* cursor forward - this is what terminal applications send for cursor back */
+      if (dspmycol < dsp_columns-1) dspmycol++;
+      return;
+    case 8:   /* back space is delete the moment */
+    case 127: /* delete */
+      if (dspmycol > 0) {
+        dspmycol--;
+        dspsetxy(0, dspmycol, dspmyrow);
+      }
+      return;
+    case 2: /* we abuse start of text as a home sequence */
+      dspmycol=dspmyrow=0;
+      return;
+    case 3: /* ETX = Update display for buffered display like Epaper */
+      dspupdate();
+      return;
+    default: /* eliminate all non printables */
+      if (c>0 && c<32) return;
+      break;
+  }
+  
+  dspsetxy(c, dspmycol, dspmyrow);
+  dspmycol++;
+  if (dspmycol == dsp_columns) {
+    if (!dspwrap) { /* we simply ignore the cursor */
+      dspmycol=0;
+      dspmyrow=(dspmyrow + 1);
+    }
+    if (dspmyrow >= dsp_rows) dspscroll(dsp_scroll_rows, 0); 
+  }
+  if (dspupdatemode == 0) dspupdate();
+}
+#endif
 
 #ifndef POSIXFRAMEBUFFER
 /* these are the graphics commands */
@@ -715,6 +1264,15 @@ void vgawrite(char c){}
  * by Alois Zingl from the Vienna Technikum. I also recommend
  * his thesis: http://members.chello.at/%7Eeasyfilter/Bresenham.pdf
  * 
+ * All drawing goes to a back buffer in memory. Lines, rects and circles
+ * are drawn as horizontal and vertical spans, the bytes of a color are 
+ * computed once in rgbcolor(). The changed area is recorded and copied 
+ * to the screen by dspgraphupdate(). In update mode 0 (SET 10,0, the 
+ * default) this happens after every graphics command, in all other 
+ * modes only with CALL 4. CALL 5 writes the back buffer to a PPM file.
+ * 
+ * Without /dev/fb0 the back buffer is FRAMEWIDTH x FRAMEHEIGHT with 
+ * 32 bit color and the code runs headless.
  */
 #include <sys/fcntl.h>
 #include <sys/ioctl.h>
@@ -724,7 +1282,10 @@ void vgawrite(char c){}
 
 /* 'global' variables to store screen info */
 char *framemem = 0;
-int framedesc = 0;
+int framedesc = -1;
+
+/* the back buffer, all drawing goes here */
+char *framebuffer = 0;
 
 /* info from the frame buffer itself */
 struct fb_var_screeninfo vinfo;
@@ -737,32 +1298,30 @@ int  framevgacolor = 0x0f;
 long framescreensize = 0;
 int framecolordepth = 0;
 
+/* the color as bytes in the order of the screen memory, and bytes per pixel */
+unsigned char framepixel[4] = {0xff, 0xff, 0xff, 0};
+int framebpp = 0;
+
+/* update mode and the changed area of the back buffer */
+uint8_t frameupdatemode = 0;
+int framedirtyx0, framedirtyy0, framedirtyx1 = -1, framedirtyy1 = -1;
+
 /* prepare the framebuffer device */
 void vgabegin() {
 
 /* see if we can open the framebuffer device */
   framedesc = open("/dev/fb0", O_RDWR);
-  if (!framedesc) {
-    printf("** error opening frame buffer \n");
-    return;
-  } 
+  if (framedesc < 0) goto headless;
 
 /* now get the variable info of the screen */
   if (ioctl(framedesc, FBIOGET_VSCREENINFO, &vinfo)) {
     printf("** error reading screen information \n");
-    return;
+    goto headless;
   }
   printf("Detected screen %dx%d, %dbpp \n", vinfo.xres, vinfo.yres, vinfo.bits_per_pixel);
 
 /* BASIC currently does 24 bit color only */
   memcpy(&orig_vinfo, &vinfo, sizeof(struct fb_var_screeninfo)); 
-/*
-  vinfo.bits_per_pixel = 24; 
-  if (ioctl(framedesc, FBIOPUT_VSCREENINFO, &vinfo)) {
-    printf("** error setting variable information \n");
-    return;
-  }
-*/
 
 /* how much color have we got */
   framecolordepth = vinfo.bits_per_pixel;
@@ -770,45 +1329,90 @@ void vgabegin() {
 /* get the fixed information of the screen */
   if (ioctl(framedesc, FBIOGET_FSCREENINFO, &finfo)) {
     printf("Error reading fixed information.\n");
-    return;
+    goto headless;
   }
 
-/* now ready to memory map the screen - evil, we assume 24 bit without checking */
-
-  framescreensize = (framecolordepth/8) * vinfo.xres * vinfo.yres;  
+/* now ready to memory map the screen */
+  framescreensize = finfo.line_length * vinfo.yres;  
   framemem = (char*)mmap(0, framescreensize, PROT_READ | PROT_WRITE, MAP_SHARED, framedesc, 0);
-  if ((int)framemem == -1) {
+  if (framemem == MAP_FAILED) {
     printf("** error failed to mmap.\n");
-    framemem=0;
-    return;
+    framemem = 0;
+    goto headless;
   }
 
-/* if all went well we have valid non -1 framemem and can continue */
+/* the back buffer starts as a copy of the screen */
+  framebuffer = (char*)malloc(framescreensize);
+  if (!framebuffer) {
+    printf("** error allocating the back buffer.\n");
+    munmap(framemem, framescreensize);
+    framemem = 0;
+    goto headless;
+  }
+  memcpy(framebuffer, framemem, framescreensize);
+  framebpp = framecolordepth/8;
+  rgbcolor(255, 255, 255);
+  return;
+
+/* no screen, draw into memory only */
+headless:
+  if (framedesc >= 0) close(framedesc);
+  framedesc = -1;
+  memset(&vinfo, 0, sizeof(vinfo));
+  memset(&finfo, 0, sizeof(finfo));
+  vinfo.xres = FRAMEWIDTH;
+  vinfo.yres = FRAMEHEIGHT;
+  framecolordepth = 32;
+  framebpp = 4;
+  finfo.line_length = FRAMEWIDTH * framebpp;
+  framescreensize = finfo.line_length * vinfo.yres;
+  framebuffer = (char*)calloc(framescreensize, 1);
+  if (!framebuffer) framescreensize = 0;
+  rgbcolor(255, 255, 255);
 }
 
 /* this function does not exist in the ESP32 world because we don't care there */
 void vgaend() {
-  if ((int)framemem) munmap(framemem, framescreensize); 
-  if (ioctl(framedesc, FBIOPUT_VSCREENINFO, &orig_vinfo)) {
-    printf("** error re-setting variable information \n");
+  if (framemem) {
+    dspgraphupdate();
+    munmap(framemem, framescreensize); 
+    framemem = 0;
   }
-  close(framedesc);
+  if (framedesc >= 0) {
+    if (ioctl(framedesc, FBIOPUT_VSCREENINFO, &orig_vinfo)) {
+      printf("** error re-setting variable information \n");
+    }
+    close(framedesc);
+    framedesc = -1;
+  }
+  free(framebuffer);
+  framebuffer = 0;
 }
 
-/* set the color variable depending on the color depth*/
+/* set the color variable depending on the color depth and split it into bytes */
 void rgbcolor(uint8_t r, uint8_t g, uint8_t b) {
-  switch (framecolordepth/8) {
+  switch (framebpp) {
   case 4:
-    framecolor = (((long)r << 16) & 0x00ff0000) | (((long)g << 8) & 0x0000ff00) | ((long)b & 0x000000ff); /* untested */
+    framecolor = (((long)r << 16) & 0x00ff0000) | (((long)g << 8) & 0x0000ff00) | ((long)b & 0x000000ff);
+    framepixel[0] = framecolor & 0xff;
+    framepixel[1] = (framecolor >> 8) & 0xff;
+    framepixel[2] = (framecolor >> 16) & 0xff;
+    framepixel[3] = 0;
     break;
   case 3:
     framecolor = (((long)r << 16) & 0x00ff0000) | (((long)g << 8) & 0x0000ff00) | ((long)b & 0x000000ff);
+    framepixel[0] = framecolor & 0xff;
+    framepixel[1] = (framecolor >> 8) & 0xff;
+    framepixel[2] = (framecolor >> 16) & 0xff;
     break;
   case 2:
     framecolor = ((long) (r & 0xff) >> 3) << 10 | ((long) (g & 0xff) >> 2) << 6 | ((long) (b & 0xff) >> 3); /* untested */
+    framepixel[0] = (framecolor & 0x1f) + (((framecolor >> 5) & 0x03) << 6);
+    framepixel[1] = (framecolor >> 7) & 0xff;
     break;
   case 1:
     framecolor = ((long) (r & 0xff) >> 5) << 5 | ((long) (g & 0xff) >> 5) << 2 | ((long) (b & 0xff) >> 6); /* untested */
+    framepixel[0] = framecolor & 0xff;
     break;
   }
 }
@@ -822,83 +1426,163 @@ void vgacolor(uint8_t c) {
   rgbcolor(base*(c&1), base*((c&2)/2), base*((c&4)/4));  
 }
 
-/* plot directly into the framebuffer */
-void plot(int x, int y) {
-  unsigned long pix_offset;
+/* add an area to the changed area */
+void framedirty(int x0, int y0, int x1, int y1) {
+  if (framedirtyx1 < 0) {
+    framedirtyx0 = x0; framedirtyy0 = y0;
+    framedirtyx1 = x1; framedirtyy1 = y1;
+    return;
+  }
+  if (x0 < framedirtyx0) framedirtyx0 = x0;
+  if (y0 < framedirtyy0) framedirtyy0 = y0;
+  if (x1 > framedirtyx1) framedirtyx1 = x1;
+  if (y1 > framedirtyy1) framedirtyy1 = y1;
+}
 
-/* is everything in range, no error here */
-  if (x < 0 || y < 0 || x >= vinfo.xres || y >= vinfo.yres) return; 
+/* copy the changed area to the screen */
+void dspgraphupdate() {
+  int y;
+  long o, l;
+
+  if (framedirtyx1 < 0) return;
+  if (framemem) {
+    o = framedirtyy0 * finfo.line_length + framedirtyx0 * framebpp;
+    l = (framedirtyx1 - framedirtyx0 + 1) * framebpp;
+    for (y = framedirtyy0; y <= framedirtyy1; y++, o += finfo.line_length) 
+      memcpy(framemem + o, framebuffer + o, l);
+  }
+  framedirtyx1 = framedirtyy1 = -1;
+}
 
-/* find the memory location */
-  pix_offset = (framecolordepth/8) * x + y * finfo.line_length;
+/* the update mode, 0 updates after each command */
+void dspsetupdatemode(uint8_t c) { frameupdatemode = c; }
+uint8_t dspgetupdatemode() { return frameupdatemode; }
 
-  if (pix_offset < 0 || pix_offset+ (framecolordepth/8-1) > framescreensize) return;
+/* called at the end of every graphics command */
+void frameupdate() {
+  if (frameupdatemode == 0) dspgraphupdate();
+}
 
-/* write to the buffer */
-  switch (framecolordepth/8) {
-  case 4:
-    *((char*)(framemem + pix_offset  )) = (unsigned char)(framecolor         & 0x000000ff);
-    *((char*)(framemem + pix_offset+1)) = (unsigned char)((framecolor >>  8) & 0x000000ff);
-    *((char*)(framemem + pix_offset+3)) = (unsigned char)((framecolor >> 16) & 0x000000ff);
-    break;
-  case 3:
-    *((char*)(framemem + pix_offset  )) = (unsigned char)(framecolor         & 0x000000ff);
-    *((char*)(framemem + pix_offset+1)) = (unsigned char)((framecolor >>  8) & 0x000000ff);
-    *((char*)(framemem + pix_offset+2)) = (unsigned char)((framecolor >> 16) & 0x000000ff);
-    break;
-  case 2:
-    *((char*)(framemem + pix_offset  )) = (unsigned char)((framecolor & 0x1f) + (((framecolor >> 5) & 0x03) << 6));
-    *((char*)(framemem + pix_offset+1)) = (unsigned char)((framecolor >> 7) & 0xff);
-    break;
-  case 1:
-    *((char*)(framemem + pix_offset  )) = (unsigned char)(framecolor         & 0x000000ff);
-    break;
+/* 
+ * a horizontal span from x0 to x1, clipped, the first pixel is written 
+ * bytewise and then doubled with memcpy, for 8 bit color this is a memset
+ */
+void framehline(int x0, int x1, int y) {
+  int t;
+  long n, c;
+  char *p;
+
+  if (x0 > x1) { t = x0; x0 = x1; x1 = t; }
+  if (!framebuffer || y < 0 || y >= vinfo.yres || x1 < 0 || x0 >= vinfo.xres) return;
+  if (x0 < 0) x0 = 0;
+  if (x1 >= vinfo.xres) x1 = vinfo.xres - 1;
+
+  p = framebuffer + y * finfo.line_length + x0 * framebpp;
+  n = (long)(x1 - x0 + 1) * framebpp;
+  if (framebpp == 1) {
+    memset(p, framepixel[0], n);
+  } else {
+    memcpy(p, framepixel, framebpp);
+    for (c = framebpp; c < n; c *= 2) memcpy(p + c, p, (n - c < c) ? n - c : c);
   }
+  framedirty(x0, y, x1, y);
+}
 
+/* a vertical span from y0 to y1, clipped */
+void framevline(int x, int y0, int y1) {
+  int t;
+  char *p;
+
+  if (y0 > y1) { t = y0; y0 = y1; y1 = t; }
+  if (!framebuffer || x < 0 || x >= vinfo.xres || y1 < 0 || y0 >= vinfo.yres) return;
+  if (y0 < 0) y0 = 0;
+  if (y1 >= vinfo.yres) y1 = vinfo.yres - 1;
+
+  p = framebuffer + y0 * finfo.line_length + x * framebpp;
+  for (t = y0; t <= y1; t++, p += finfo.line_length) memcpy(p, framepixel, framebpp);
+  framedirty(x, y0, x, y1);
 }
 
-/* Bresenham's algorith from Wikipedia */
-void line(int x0, int y0, int x1, int y1) {
+/* plot into the back buffer */
+void frameplot(int x, int y) {
+  char *p;
+
+/* is everything in range, no error here */
+  if (!framebuffer || x < 0 || y < 0 || x >= vinfo.xres || y >= vinfo.yres) return; 
+
+  p = framebuffer + y * finfo.line_length + x * framebpp;
+  memcpy(p, framepixel, framebpp);
+  framedirty(x, y, x, y);
+}
+
+void plot(int x, int y) {
+  frameplot(x, y);
+  frameupdate();
+}
+
+/* 
+ * Bresenham's algorith from Wikipedia, flat lines are collected 
+ * into horizontal runs, steep lines into vertical runs
+ */
+void frameline(int x0, int y0, int x1, int y1) {
   int dx, dy, sx, sy;
   int error, e2;
+  int xs, ys, xp, yp;
   
+  if (y0 == y1) { framehline(x0, x1, y0); return; }
+  if (x0 == x1) { framevline(x0, y0, y1); return; }
+
   dx=abs(x0-x1);
   sx=x0 < x1 ? 1 : -1;
   dy=-abs(y1-y0);
   sy=y0 < y1 ? 1 : -1;
   error=dx+dy;
+  xs=x0;
+  ys=y0;
 
   while(1) {
-    plot(x0, y0);
     if (x0 == x1 && y0 == y1) break;
+    xp=x0;
+    yp=y0;
     e2=2*error;
     if (e2 > dy) {
-      if (x0 == x1) break;
       error=error+dy;
       x0=x0+sx;
     }
     if (e2 <= dx) {
-      if (y0 == y1) break;
       error=error+dx;
       y0=y0+sy;
     }
+    if (dx >= -dy) {
+      if (y0 != yp) { framehline(xs, xp, ys); xs=x0; ys=y0; }
+    } else {
+      if (x0 != xp) { framevline(xs, ys, yp); xs=x0; ys=y0; }
+    }
   }
+  if (dx >= -dy) framehline(xs, x1, ys); else framevline(xs, ys, y1);
+}
+
+void line(int x0, int y0, int x1, int y1) {
+  frameline(x0, y0, x1, y1);
+  frameupdate();
 }
 
-/* rects could also be drawn with hline and vline */
+/* rects are two horizontal and two vertical spans */
 void rect(int x0, int y0, int x1, int y1) {
-  line(x0, y0, x1, y0);
-  line(x1, y0, x1, y1);
-  line(x1, y1, x0, y1);
-  line(x0, y1, x0, y0); 
+  framehline(x0, x1, y0);
+  framehline(x0, x1, y1);
+  framevline(x0, y0, y1);
+  framevline(x1, y0, y1);
+  frameupdate();
 }
 
-/* filled rect, also just using line right now */
+/* filled rect, one span per row */
 void frect(int x0, int y0, int x1, int y1) {
-  int dx, sx;
-  int x;
-  sx=x0 < x1 ? 1 : -1;
-  for(x=x0; x != x1; x=x+sx) line(x, y0, x, y1);
+  int y, t;
+
+  if (y0 > y1) { t = y0; y0 = y1; y1 = t; }
+  for (y = y0; y <= y1; y++) framehline(x0, x1, y);
+  frameupdate();
 }
 
 /* Bresenham for circles, based on Alois Zingl's work */
@@ -908,29 +1592,73 @@ void circle(int x0, int y0, int r) {
   y=0; 
   err=2-2*r;
   do {
-    plot(x0-x, y0+y);
-    plot(x0-y, y0-x);
-    plot(x0+x, y0-y);
-    plot(x0+y, y0+x);
+    frameplot(x0-x, y0+y);
+    frameplot(x0-y, y0-x);
+    frameplot(x0+x, y0-y);
+    frameplot(x0+y, y0+x);
     r=err;
     if (r <= y) err+=++y*2+1;
     if (r > x || err > y) err+=++x*2+1;
   } while (x < 0);
+  frameupdate();
 }
 
-/* for filled circles draw lines instead of points */
+/* for filled circles draw spans, each row only once */
 void fcircle(int x0, int y0, int r) {
-  int x, y, err;
+  int x, y, err, yl;
   x=-r;
   y=0; 
   err=2-2*r;
+  yl=-1;
   do {
-    line(x0-x, y0+y, x0+x, y0+y);
-    line(x0+x, y0-y, x0-x, y0-y);
+    if (y != yl) {
+      framehline(x0-x, x0+x, y0+y);
+      if (y) framehline(x0+x, x0-x, y0-y);
+      yl=y;
+    }
     r=err;
     if (r <= y) err+=++y*2+1;
     if (r > x || err > y) err+=++x*2+1;
   } while (x < 0);
+  frameupdate();
+}
+
+/* write the back buffer as a binary PPM file */
+void vgadump(const char* filename) {
+  FILE* file;
+  char *p;
+  int x, y;
+  unsigned char rgb[3];
+  unsigned int c;
+
+  if (!framebuffer) return;
+  file = fopen(filename, "wb");
+  if (!file) {
+    ioer = 1;
+    return;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", vinfo.xres, vinfo.yres);
+  for (y = 0; y < vinfo.yres; y++) {
+    p = framebuffer + y * finfo.line_length;
+    for (x = 0; x < vinfo.xres; x++, p += framebpp) {
+      switch (framebpp) {
+      case 4:
+      case 3:
+        rgb[0] = p[2]; rgb[1] = p[1]; rgb[2] = p[0];
+        break;
+      case 2:
+        c = ((unsigned char)p[1] << 7) | (((unsigned char)p[0] >> 6) << 5) | ((unsigned char)p[0] & 0x1f);
+        rgb[0] = ((c >> 10) & 0x1f) << 3; rgb[1] = ((c >> 5) & 0x1f) << 3; rgb[2] = (c & 0x1f) << 3;
+        break;
+      case 1:
+        c = (unsigned char)p[0];
+        rgb[0] = (c >> 5) << 5; rgb[1] = ((c >> 2) & 0x07) << 5; rgb[2] = (c & 0x03) << 6;
+        break;
+      }
+      fwrite(rgb, 3, 1, file);
+    }
+  }
+  fclose(file);
 }
 
 /* not needed really, now, later yes ;-) */
@@ -952,8 +1680,10 @@ char kbdread() { return 0;}
 char kbdcheckch() { return 0;}
 
 /* vt52 code stubs - unused here - needed for basic.c */
+#ifndef POSIXDISPLAY
 uint8_t vt52avail() {return 0;}
 char vt52read() { return 0; }
+#endif
 
 /* Display driver would be here, together with vt52 */
 
@@ -997,56 +1727,789 @@ void rtcset(uint8_t i, uint16_t v) {}
 void netbegin() {}
 uint8_t netconnected() { return 0; }
 void mqttbegin() {}
-uint8_t mqttstat(uint8_t c) {return 0; }
-uint8_t mqttstate() {return 0;}
+int mqttstat(uint8_t c) {return 0; }
+int mqttstate() {return 0;}
 void mqttsubscribe(const char *t) {}
 void mqttsettopic(const char *t) {}
 void mqttouts(const char *m, uint16_t l) {}
 uint16_t mqttins(char *b, uint16_t nb) { return 0; };
 char mqttread() {return 0;};
 #else 
-/* we use mosquitto */
-#include <mosquitto.h>
+/* 
+ * A small MQTT 3.1.1 client on plain POSIX sockets, the API is the 
+ * one of the PubSubClient based code of the Arduino platforms.
+ *
+ * The broker is set with MQTTSERVER and MQTTPORT in hardware.h. The 
+ * client connects on first use and reconnects with exponential backoff.
+ * The state codes are the ones of PubSubClient, 0 is connected.
+ *
+ * Inbound messages go into a queue of MQTTQUEUESIZE messages. The 
+ * first message of the queue is the one BASIC reads from. 
+ *
+ * Outbound PRINT output is collected in mqtt_obuffer and published 
+ * on newline. The packets are batched in a socket buffer which is 
+ * written if full, after MQTTFLUSHINTERVAL ms or before waiting for 
+ * the broker. 
+ *
+ * Published messages have QoS 0 or 1 set with SET 26. QoS 1 messages 
+ * are kept until the PUBACK and resent after a reconnect. Subscriptions 
+ * request the same QoS. 
+ */
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+/* the packet types */
+#define MQTTCONNECT 0x10
+#define MQTTCONNACK 0x20
+#define MQTTPUBLISH 0x30
+#define MQTTPUBACK 0x40
+#define MQTTSUBSCRIBE 0x82
+#define MQTTSUBACK 0x90
+#define MQTTUNSUBSCRIBE 0xa2
+#define MQTTUNSUBACK 0xb0
+#define MQTTPINGREQ 0xc0
+#define MQTTPINGRESP 0xd0
+#define MQTTDISCONNECT 0xe0
+
+/* the topics and the name, as on Arduino */
+char mqtt_otopic[MQTTLENGTH];
+char mqtt_itopic[MQTTLENGTH];
+char mqttname[MQTTNAMELENGTH] = "iotbasicxxx";
+
+/* the message BASIC reads from and the outgoing message */
+char mqtt_buffer[MQTTBLENGTH];
+uint16_t mqtt_messagelength = 0;
+char mqtt_obuffer[MQTTBLENGTH];
+uint16_t mqtt_charsforsend = 0;
+
+/* the inbound queue */
+char mqttqueue[MQTTQUEUESIZE][MQTTBLENGTH];
+uint16_t mqttqueuelength[MQTTQUEUESIZE];
+uint8_t mqttqhead = 0;
+uint8_t mqttqcount = 0;
+
+/* QoS 1 messages waiting for their PUBACK */
+typedef struct {
+  uint16_t id;
+  uint16_t length;
+  char topic[MQTTLENGTH];
+  char payload[MQTTBLENGTH];
+} mqttinflight_t;
+
+mqttinflight_t mqttinflight[MQTTINFLIGHT];
+uint8_t mqttninflight = 0;
+
+/* the connection */
+int mqttfd = -1;
+int8_t mqtt_state = -1;
+uint8_t mqttqos = 0;
+uint16_t mqttpacketid = 0;
+uint32_t mqttlastout = 0;
+uint32_t mqttlastin = 0;
+uint32_t mqttlastpoll = 0;
+uint8_t mqttpingpending = 0;
+
+/* the acknowledgement the client waits for, 0 if none */
+uint8_t mqttwaittype = 0;
+uint16_t mqttwaitid = 0;
+uint8_t mqttwaitcode = 0;
+
+/* the socket buffers, mqttsfirst is the time of the oldest byte not sent */
+char mqttsbuf[MQTTSBUFSIZE];
+uint16_t mqttslength = 0;
+uint32_t mqttsfirst = 0;
+char mqttrbuf[MQTTRBUFSIZE];
+uint16_t mqttrlength = 0;
+uint32_t mqttrskip = 0;
+
+void mqttprocess();
+
+/* the name of the client, generated pseudo randomly to avoid naming conflicts */
+void mqttsetname() {
+  uint32_t m = millis() + getpid();
+  mqttname[8]=(char)(65+m%26);
+  m=m/26;
+  mqttname[9]=(char)(65+m%26);
+  m=m/26;
+  mqttname[10]=(char)(65+m%26);
+}
+
+/* drop the connection, the inflight messages are kept for the reconnect */
+void mqttdrop(int8_t s) {
+  if (mqttfd >= 0) close(mqttfd);
+  mqttfd = -1;
+  mqtt_state = s;
+  mqttslength = 0;
+  mqttrlength = 0;
+  mqttrskip = 0;
+  mqttpingpending = 0;
+}
+
+/* write the socket buffer, waits for the socket if it is full */
+uint8_t mqttflush() {
+  uint16_t i = 0;
+  ssize_t n;
+  struct pollfd p;
+
+  while (i < mqttslength && mqttfd >= 0) {
+    n = send(mqttfd, mqttsbuf+i, mqttslength-i, MSG_NOSIGNAL);
+    if (n > 0) {
+      i += n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      p.fd = mqttfd;
+      p.events = POLLOUT;
+      if (poll(&p, 1, MQTTTIMEOUT) <= 0) { mqttdrop(-4); return 0; }
+    } else {
+      mqttdrop(-3);
+      return 0;
+    }
+  }
+  mqttslength = 0;
+  mqttlastout = millis();
+  return (mqttfd >= 0);
+}
+
+/* append a packet to the socket buffer */
+uint8_t mqttsend(const char* b, uint16_t l) {
+  if (mqttfd < 0) return 0;
+  if (mqttslength + l > MQTTSBUFSIZE && !mqttflush()) return 0;
+  if (mqttslength == 0) mqttsfirst = millis();
+  memcpy(mqttsbuf+mqttslength, b, l);
+  mqttslength += l;
+  return 1;
+}
+
+/* the fixed header with the variable length encoding, returns its length */
+uint8_t mqttheader(char* b, uint8_t t, uint32_t l) {
+  uint8_t i = 1;
+
+  b[0] = t;
+  do {
+    b[i] = l % 128;
+    l = l / 128;
+    if (l > 0) b[i] |= 0x80;
+    i++;
+  } while (l > 0);
+  return i;
+}
+
+/* a string with its two byte length */
+uint16_t mqttputstring(char* b, const char* s) {
+  uint16_t l = strlen(s);
+
+  b[0] = l >> 8;
+  b[1] = l & 0xff;
+  memcpy(b+2, s, l);
+  return l+2;
+}
+
+/* the short packets, PUBACK, PINGREQ and DISCONNECT */
+uint8_t mqttsendshort(uint8_t t, uint16_t id, uint8_t l) {
+  char b[4];
+
+  b[0] = t;
+  b[1] = l;
+  b[2] = id >> 8;
+  b[3] = id & 0xff;
+  return mqttsend(b, l+2);
+}
+
+/* read what the socket has and process the complete packets */
+uint8_t mqttreceive() {
+  ssize_t n;
+
+  if (mqttfd < 0) return 0;
+  for (;;) {
+    if (mqttrlength == MQTTRBUFSIZE) return 1;
+    n = recv(mqttfd, mqttrbuf+mqttrlength, MQTTRBUFSIZE-mqttrlength, 0);
+    if (n > 0) {
+      mqttlastin = millis();
+      if (mqttrskip > 0) {
+        if (n <= mqttrskip) { mqttrskip -= n; continue; }
+        memmove(mqttrbuf, mqttrbuf+mqttrskip, n-mqttrskip);
+        n -= mqttrskip;
+        mqttrskip = 0;
+      }
+      mqttrlength += n;
+      mqttprocess();
+      if (mqttfd < 0) return 0;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return 1;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      mqttdrop(-3);
+      return 0;
+    }
+  }
+}
+
+/* put a message into the queue, if the queue is full the message is lost */
+void mqttenqueue(const char* p, uint32_t l) {
+  uint8_t i;
+
+  if (mqttqcount == MQTTQUEUESIZE) return;
+  if (l > MQTTBLENGTH) l = MQTTBLENGTH;
+  i = (mqttqhead + mqttqcount) % MQTTQUEUESIZE;
+  memcpy(mqttqueue[i], p, l);
+  mqttqueuelength[i] = l;
+  mqttqcount++;
+}
+
+/* move the next message of the queue into the BASIC buffer */
+void mqttnextmessage() {
+  if (mqtt_messagelength > 0 || mqttqcount == 0) return;
+  mqtt_messagelength = mqttqueuelength[mqttqhead];
+  memcpy(mqtt_buffer, mqttqueue[mqttqhead], mqtt_messagelength);
+  mqttqhead = (mqttqhead + 1) % MQTTQUEUESIZE;
+  mqttqcount--;
+}
+
+/* remove an acknowledged QoS 1 message */
+void mqttacknowledge(uint16_t id) {
+  uint8_t i;
+
+  for (i = 0; i < mqttninflight; i++) {
+    if (mqttinflight[i].id == id) {
+      mqttninflight--;
+      if (i < mqttninflight) mqttinflight[i] = mqttinflight[mqttninflight];
+      return;
+    }
+  }
+}
+
+/* 
+ * process the complete packets in the receive buffer, a packet larger 
+ * than the buffer is skipped 
+ */
+void mqttprocess() {
+  uint16_t i = 0, h, tl, id;
+  uint32_t l, m;
+  uint8_t t, q;
+  char* b;
+
+  while (mqttrlength - i >= 2) {
+    b = mqttrbuf+i;
+    t = b[0];
+    l = 0;
+    m = 1;
+    for (h = 1; h < 5 && i+h < mqttrlength; h++) {
+      l += (b[h] & 0x7f) * m;
+      m *= 128;
+      if (!(b[h] & 0x80)) break;
+    }
+    if (h == 5) { mqttdrop(-3); return; }
+    if (i+h >= mqttrlength) break;
+    h++;
+
+    /* a packet that never fits */
+    if (h+l > MQTTRBUFSIZE) {
+      mqttrskip = h + l - (mqttrlength - i);
+      mqttrlength = 0;
+      return;
+    }
+    if (h+l > mqttrlength - i) break;
+    b += h;
+
+    switch (t & 0xf0) {
+      case MQTTPUBLISH:
+        q = (t >> 1) & 3;
+        if (l < 2) break;
+        tl = ((uint8_t)b[0] << 8) + (uint8_t)b[1];
+        if (tl + 2 > l) break;
+        tl += 2;
+        id = 0;
+        if (q > 0) {
+          if (tl + 2 > l) break;
+          id = ((uint8_t)b[tl] << 8) + (uint8_t)b[tl+1];
+          tl += 2;
+        }
+        mqttenqueue(b+tl, l-tl);
+        if (q == 1) mqttsendshort(MQTTPUBACK, id, 2);
+        break;
+      case MQTTPUBACK:
+        if (l >= 2) mqttacknowledge(((uint8_t)b[0] << 8) + (uint8_t)b[1]);
+        break;
+      case MQTTCONNACK:
+        if (mqttwaittype == MQTTCONNACK && l >= 2) {
+          mqttwaitcode = b[1];
+          mqttwaittype = 0;
+        }
+        break;
+      case MQTTSUBACK:
+      case MQTTUNSUBACK:
+        if (mqttwaittype == (t & 0xf0) && l >= 2 && mqttwaitid == ((uint8_t)b[0] << 8) + (uint8_t)b[1]) {
+          mqttwaitcode = (l > 2) ? b[2] : 0;
+          mqttwaittype = 0;
+        }
+        break;
+      case MQTTPINGRESP:
+        mqttpingpending = 0;
+        break;
+    }
+    if (mqttfd < 0) return;
+    i += h+l;
+  }
+  if (i > 0) {
+    memmove(mqttrbuf, mqttrbuf+i, mqttrlength-i);
+    mqttrlength -= i;
+  }
+}
+
+/* send everything and wait at most t ms for the broker */
+void mqttpoll(int t) {
+  struct pollfd p;
+
+  if (!mqttflush()) return;
+  p.fd = mqttfd;
+  p.events = POLLIN;
+  if (poll(&p, 1, t) > 0) mqttreceive();
+}
+
+/* wait for the acknowledgement set in mqttwaittype */
+uint8_t mqttwait() {
+  uint32_t m = millis();
+
+  while (mqttwaittype && mqttfd >= 0) {
+    if (millis() - m > MQTTTIMEOUT) { mqttwaittype = 0; mqttdrop(-4); return 0; }
+    mqttpoll(10);
+  }
+  return (mqttfd >= 0);
+}
+
+/* the next packet id, never 0 */
+uint16_t mqttnextid() {
+  if (++mqttpacketid == 0) mqttpacketid = 1;
+  return mqttpacketid;
+}
+
+/* a PUBLISH packet, dup is set on resend */
+uint8_t mqttpublish(const char* t, const char* p, uint16_t l, uint8_t q, uint16_t id, uint8_t dup) {
+  char b[MQTTLENGTH+MQTTBLENGTH+10];
+  uint16_t n = strlen(t) + 2 + l + ((q > 0) ? 2 : 0);
+  uint16_t i;
+
+  i = mqttheader(b, MQTTPUBLISH | (q << 1) | (dup ? 0x08 : 0), n);
+  i += mqttputstring(b+i, t);
+  if (q > 0) {
+    b[i++] = id >> 8;
+    b[i++] = id & 0xff;
+  }
+  memcpy(b+i, p, l);
+  return mqttsend(b, i+l);
+}
+
+/* 
+ * open the socket and send CONNECT, the socket is non blocking 
+ * after the connect 
+ */
+uint8_t mqttconnect() {
+  struct addrinfo hints, *res, *r;
+  char port[8];
+  char b[MQTTNAMELENGTH+sizeof(MQTTUSER)+sizeof(MQTTPASSWD)+32];
+  uint16_t i, n;
+  int one = 1;
+  uint8_t f;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(port, sizeof(port), "%d", MQTTPORT);
+  if (getaddrinfo(MQTTSERVER, port, &hints, &res) != 0) { mqtt_state = -2; return 0; }
+  for (r = res; r; r = r->ai_next) {
+    mqttfd = socket(r->ai_family, r->ai_socktype, r->ai_protocol);
+    if (mqttfd < 0) continue;
+    if (connect(mqttfd, r->ai_addr, r->ai_addrlen) == 0) break;
+    close(mqttfd);
+    mqttfd = -1;
+  }
+  freeaddrinfo(res);
+  if (mqttfd < 0) { mqtt_state = -2; return 0; }
+  setsockopt(mqttfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fcntl(mqttfd, F_SETFL, fcntl(mqttfd, F_GETFL) | O_NONBLOCK);
+
+  /* the variable header and the payload of CONNECT, clean session */
+  f = 0x02;
+  n = 10 + 2 + strlen(mqttname);
+  if (*MQTTUSER) { f |= 0x80; n += 2 + strlen(MQTTUSER); }
+  if (*MQTTPASSWD) { f |= 0x40; n += 2 + strlen(MQTTPASSWD); }
+  i = mqttheader(b, MQTTCONNECT, n);
+  i += mqttputstring(b+i, "MQTT");
+  b[i++] = 4;
+  b[i++] = f;
+  b[i++] = MQTTKEEPALIVE >> 8;
+  b[i++] = MQTTKEEPALIVE & 0xff;
+  i += mqttputstring(b+i, mqttname);
+  if (*MQTTUSER) i += mqttputstring(b+i, MQTTUSER);
+  if (*MQTTPASSWD) i += mqttputstring(b+i, MQTTPASSWD);
+  mqttsend(b, i);
+
+  mqttwaittype = MQTTCONNACK;
+  if (!mqttwait()) { mqtt_state = -4; return 0; }
+  if (mqttwaitcode != 0) { mqttdrop(mqttwaitcode); return 0; }
+  mqtt_state = 0;
+  mqttlastin = millis();
+  return 1;
+}
+
+/* SUBSCRIBE and UNSUBSCRIBE, waits for the acknowledgement */
+uint8_t mqttsubscription(uint8_t t, const char* topic) {
+  char b[MQTTLENGTH+10];
+  uint16_t i, id = mqttnextid();
+
+  i = mqttheader(b, t, 2 + 2 + strlen(topic) + ((t == MQTTSUBSCRIBE) ? 1 : 0));
+  b[i++] = id >> 8;
+  b[i++] = id & 0xff;
+  i += mqttputstring(b+i, topic);
+  if (t == MQTTSUBSCRIBE) b[i++] = mqttqos;
+  if (!mqttsend(b, i)) return 0;
+  mqttwaittype = (t == MQTTSUBSCRIBE) ? MQTTSUBACK : MQTTUNSUBACK;
+  mqttwaitid = id;
+  if (!mqttwait()) return 0;
+  return (mqttwaitcode != 0x80);
+}
+
+/* 
+ * the loop function, polls the socket once per ms, sends the batched
+ * packets and keeps the connection alive
+ */
+void mqttloop() {
+  uint32_t m;
+
+  if (mqttfd < 0) return;
+  m = millis();
+  if (m == mqttlastpoll) return;
+  mqttlastpoll = m;
+  mqttreceive();
+  if (mqttfd < 0) return;
+  if (mqttslength > 0 && m - mqttsfirst >= MQTTFLUSHINTERVAL) mqttflush();
+  if (m - mqttlastin > MQTTKEEPALIVE*1500L) { mqttdrop(-4); return; }
+  if (!mqttpingpending && (m - mqttlastout > MQTTKEEPALIVE*500L || m - mqttlastin > MQTTKEEPALIVE*500L)) {
+    mqttsendshort(MQTTPINGREQ, 0, 0);
+    mqttpingpending = 1;
+    mqttflush();
+  }
+}
+
 /* we assume to be on the network */
 void netbegin() {}
 uint8_t netconnected() { return 1; }
-/* the mqtt code */
-void mqttbegin() {}
-uint8_t mqttstat(uint8_t c) {return 0; }
-uint8_t mqttstate() {return 0;}
-void mqttsubscribe(const char *t) {}
-void mqttsettopic(const char *t) {}
-void mqttouts(const char *m, uint16_t l) {}
-uint16_t mqttins(char *b, uint16_t nb) { return 0; };
-char mqttread() {return 0;};
+void netreconnect() {}
+
+/* stopping the network ends the MQTT session */
+void netstop() {
+  if (mqttfd < 0) return;
+  mqttsendshort(MQTTDISCONNECT, 0, 0);
+  mqttflush();
+  mqttdrop(-1);
+}
+
+/* starting mqtt purges all topics, the connect happens on first use */
+void mqttbegin() {
+  *mqtt_itopic=0;
+  *mqtt_otopic=0;
+  mqtt_charsforsend=0;
+  mqtt_messagelength=0;
+  mqttqcount=0;
+  mqttninflight=0;
+}
+
+/* the interface to the usr function, 1 is the state, negative on errors, 2 is the queue, 3 the unacknowledged messages */
+int mqttstat(uint8_t c) {
+  switch (c) {
+    case 0: 
+      return 1;
+    case 1: 
+      return mqttstate();
+    case 2:
+      mqttloop();
+      return mqttqcount + (mqtt_messagelength > 0);
+    case 3:
+      return mqttninflight;
+    case 4:
+      return mqttqos;
+  }
+  return 0; 
+}
+
+/* set the QoS of publish and subscribe */
+void mqttset(uint8_t q) { if (q < 2) mqttqos = q; else ioer = 1; }
+
+/* 
+ * reconnecting mqtt - exponential backoff here 
+ * exponental backoff reconnect in 10 ms * 2^n intervals
+ * after the reconnect the topic is subscribed again and the 
+ * unacknowledged QoS 1 messages are resent 
+ */
+uint8_t mqttreconnect() {
+  uint16_t timer=10;
+  uint8_t i;
+
+  if (mqttfd >= 0 && mqtt_state == 0) return 1;
+  mqttdrop(mqtt_state);
+  mqttsetname();
+  while (timer < 400) {
+    if (mqttconnect()) break;
+    bdelay(timer);
+    timer=timer*2;
+  }
+  if (mqttfd < 0) return 0;
+
+  if (*mqtt_itopic && !mqttsubscription(MQTTSUBSCRIBE, mqtt_itopic)) return 0;
+  for (i = 0; i < mqttninflight; i++) 
+    mqttpublish(mqttinflight[i].topic, mqttinflight[i].payload, mqttinflight[i].length, 1, mqttinflight[i].id, 1);
+  return (mqttfd >= 0);
+}
+
+/* mqtt state information */
+int mqttstate() {
+  return mqtt_state;
+}
+
+/* subscribing to a topic  */
+void mqttsubscribe(const char *t) {
+  uint16_t i;
+
+  for (i=0; i<MQTTLENGTH; i++) {
+    if ((mqtt_itopic[i]=t[i]) == 0 ) break;
+  }
+  mqtt_itopic[MQTTLENGTH-1]=0;
+
+/* a reconnect subscribes the new topic */
+  if (mqttfd < 0 || mqtt_state != 0) {
+    if (!mqttreconnect()) ioer=1;
+    return;
+  }
+  if (!mqttsubscription(MQTTSUBSCRIBE, mqtt_itopic)) ioer=1;
+}
+
+void mqttunsubscribe() {
+  if (!mqttreconnect()) {ioer=1; return;};
+  if (!mqttsubscription(MQTTUNSUBSCRIBE, mqtt_itopic)) ioer=1;
+  *mqtt_itopic=0;
+}
+
+/*
+ * set the topic we pushlish, coming from OPEN
+ * BASIC can do only one topic.
+ */
+void mqttsettopic(const char *t) {
+  uint16_t i;
+
+  for (i=0; i<MQTTLENGTH; i++) {
+    if ((mqtt_otopic[i]=t[i]) == 0 ) break;
+  }
+  mqtt_otopic[MQTTLENGTH-1]=0;
+}
+
+/* 
+ * publish the collected output, with QoS 1 wait for a free inflight 
+ * slot first 
+ */
+void mqttpublishbuffer(uint16_t l) {
+  uint32_t m;
+  mqttinflight_t* f;
+
+  if (!mqttreconnect()) {ioer=1; return;};
+  if (mqttqos == 0) {
+    if (!mqttpublish(mqtt_otopic, mqtt_obuffer, l, 0, 0, 0)) ioer=1;
+    return;
+  }
+  m = millis();
+  while (mqttninflight == MQTTINFLIGHT) {
+    if (mqttfd < 0 || millis() - m > MQTTTIMEOUT) {ioer=1; return;};
+    mqttpoll(10);
+  }
+  f = &mqttinflight[mqttninflight++];
+  f->id = mqttnextid();
+  f->length = l;
+  memcpy(f->topic, mqtt_otopic, MQTTLENGTH);
+  memcpy(f->payload, mqtt_obuffer, l);
+  if (!mqttpublish(f->topic, f->payload, l, 1, f->id, 0)) ioer=1;
+}
+
+/* 
+ *  print a mqtt message 
+ *  we buffer until we reach either cr or until the buffer is full
+ *  this is needed to do things like PRINT A,B,C as one message
+ */
+void mqttouts(const char *m, uint16_t l) {
+  uint16_t i=0;
+
+  while (i < l) {
+    mqtt_obuffer[mqtt_charsforsend++]=m[i++];
+    if (mqtt_obuffer[mqtt_charsforsend-1] == '\n') {
+      mqttpublishbuffer(mqtt_charsforsend-1);
+      mqtt_charsforsend=0;
+    } else if (mqtt_charsforsend == MQTTBLENGTH) {
+      mqttpublishbuffer(mqtt_charsforsend);
+      mqtt_charsforsend=0;
+    }
+  }
+} 
+
+/* the write command is simple */
+void mqttwrite(const char c) { mqttouts(&c, 1); }
+
+/* return the messagelength as avail */
+uint16_t mqttavailable() {
+  mqttloop();
+  mqttnextmessage();
+  return mqtt_messagelength;
+}
+
+/* checkch looks at the first character */
+char mqttcheckch() {
+  if (mqttavailable() > 0) return mqtt_buffer[0]; else return 0;
+}
+
+/* 
+ * ins copies the buffer into a basic string 
+ *  - behold the jabberwock - length gynmastics 
+ */
+uint16_t mqttins(char *b, uint16_t nb) {
+  uint16_t z;
+
+  (void) mqttavailable();
+  for (z=0; z<nb && z<mqtt_messagelength; z++) b[z+1]=mqtt_buffer[z];
+  b[0]=z;
+  mqtt_messagelength=0;
+  *mqtt_buffer=0;
+  return z;
+}
+
+/* just one character to emulate basic get */
+char mqttread() {
+  char ch=0;
+  uint16_t i;
+
+  if (mqttavailable() > 0) {
+    ch=mqtt_buffer[0];
+    for (i=0; i<mqtt_messagelength-1; i++) mqtt_buffer[i]=mqtt_buffer[i+1];
+    mqtt_messagelength--;
+  }
+  return ch;
+}
 #endif
 
 /* 
  *  EEPROM handling, these function enable the @E array and 
  *  loading and saving to EEPROM with the "!" mechanism
  *  a filesystem based dummy
+ *
+ *  With POSIXEEPROMMMAP the file eeprom.dat is mapped into memory, 
+ *  eupdate() is a store to the page and the range of changed bytes 
+ *  is recorded. eflush() syncs only the pages of this range. Without
+ *  mmap, or if mapping fails, the EEPROM is a buffer that is written 
+ *  to the file only if it changed.
  */ 
-int8_t eeprom[EEPROMSIZE];
+#if EEPROMSIZE > 65535
+#error "EEPROMSIZE must fit the 16 bit addresses of eread() and eupdate()"
+#endif
+
+int8_t ebuffer[EEPROMSIZE];
+int8_t* eeprom = ebuffer;
+
+/* the changed range, low is inclusive, high exclusive, high can be EEPROMSIZE and needs more than 16 bit */
+uint32_t edirtylow = EEPROMSIZE;
+uint32_t edirtyhigh = 0;
+
+#ifdef POSIXEEPROMMMAP
+int efd = -1;
+
+/* map the file, a new or short file is filled with -1 */
+int8_t emap() {
+  struct stat st;
+  void* m;
+  long i;
+
+  efd = open("eeprom.dat", O_RDWR | O_CREAT, 0644);
+  if (efd < 0) return 0;
+  if (fstat(efd, &st) < 0 || (st.st_size < EEPROMSIZE && ftruncate(efd, EEPROMSIZE) < 0)) {
+    close(efd);
+    efd = -1;
+    return 0;
+  }
+  m = mmap(0, EEPROMSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, efd, 0);
+  if (m == MAP_FAILED) {
+    close(efd);
+    efd = -1;
+    return 0;
+  }
+  eeprom = (int8_t*) m;
+  if (st.st_size < EEPROMSIZE) {
+    for (i = st.st_size; i < EEPROMSIZE; i++) eeprom[i] = -1;
+    edirtylow = st.st_size;
+    edirtyhigh = EEPROMSIZE;
+  }
+  return 1;
+}
+#endif
+
 void ebegin(){ 
   int i;
   FILE* efile;
+#ifdef POSIXEEPROMMMAP
+  if (emap()) return;
+#endif
   for (i=0; i<EEPROMSIZE; i++) eeprom[i]=-1;
   efile=fopen("eeprom.dat", "r");
-  if (efile) fread(eeprom, EEPROMSIZE, 1, efile);
+  if (efile) {
+    fread(eeprom, EEPROMSIZE, 1, efile);
+    fclose(efile);
+  }
 }
 
 void eflush(){
   FILE* efile;
+#ifdef POSIXEEPROMMMAP
+  long pagesize, low;
+#endif
+
+  /* nothing changed, nothing to write */
+  if (edirtylow >= edirtyhigh) return;
+
+#ifdef POSIXEEPROMMMAP
+  if (efd >= 0) {
+    pagesize = sysconf(_SC_PAGESIZE);
+    low = edirtylow / pagesize * pagesize;
+    msync((char*)eeprom + low, edirtyhigh - low, MS_SYNC);
+    edirtylow = EEPROMSIZE;
+    edirtyhigh = 0;
+    return;
+  }
+#endif
+
   efile=fopen("eeprom.dat", "w");
   if (efile) { 
     fwrite(eeprom, EEPROMSIZE, 1, efile);
     fclose(efile);
+    edirtylow = EEPROMSIZE;
+    edirtyhigh = 0;
   }
 }
 
 uint16_t elength() { return EEPROMSIZE; }
-void eupdate(uint16_t a, int8_t c) { if (a>=0 && a<EEPROMSIZE) eeprom[a]=c; }
-int8_t eread(uint16_t a) { if (a>=0 && a<EEPROMSIZE) return eeprom[a]; else return -1;  }
+
+void eupdate(uint16_t a, int8_t c) { 
+  if (a<EEPROMSIZE && eeprom[a]!=c) {
+    eeprom[a]=c;
+    if (a<edirtylow) edirtylow=a;
+    if (a>=edirtyhigh) edirtyhigh=a+1;
+  }
+}
+
+int8_t eread(uint16_t a) { if (a<EEPROMSIZE) return eeprom[a]; else return -1;  }
+
+/* the buffer or the mapped file, both can be read in place */
+int8_t* eaddress() { return eeprom; }
 
 
 /* 
@@ -1133,6 +2596,17 @@ unsigned long millis() {
   ftime(&thetime);
   return (thetime.time-start_time.time)*1000+(thetime.millitm-start_time.millitm);
 }
+
+/* micros for the profiler, counted from timeinit() like millis() */
+#ifndef MSDOS
+unsigned long micros() {
+  struct timeval thetime;
+  gettimeofday(&thetime, 0);
+  return (thetime.tv_sec-start_time.time)*1000000+thetime.tv_usec-start_time.millitm*1000;
+}
+#else
+unsigned long micros() { return millis()*1000; }
+#endif
 #endif
 
 void playtone(uint8_t pin, uint16_t frequency, uint16_t duration, uint8_t volume) {}
@@ -1225,7 +2699,13 @@ void longyieldfunction() {
 #endif
 }
 
-void yieldschedule() {}
+/* the printer port output is written after every statement, mqtt is polled */
+void yieldschedule() {
+  prtflush();
+#ifdef POSIXMQTT
+  mqttloop();
+#endif
+}
 
 /* 
  *  The file system driver - all methods needed to support BASIC fs access
@@ -1234,16 +2714,175 @@ void yieldschedule() {}
  * file system code is a wrapper around the POSIX API
  */
 void fsbegin() {}
-FILE* ifile;
-FILE* ofile;
+BSTATE FILE* ifile;
+BSTATE FILE* ofile;
 #ifndef MSDOS
-DIR* root;
-struct dirent* file; 
+BSTATE DIR* root;
+BSTATE struct dirent* file; 
 #else
-void* root;
-void* file;
+BSTATE void* root;
+BSTATE void* file;
 #endif 
 
+/* 
+ * Interpreter contexts, statecopy() copies n bytes of a variable to 
+ * a context buffer p if s is 1 and back if s is 0, with p == 0 it only 
+ * counts. iocontext() does this for the runtime state of an interpreter, 
+ * the streams, the flags and the open files. 
+ */
+#ifdef HASCONTEXTS
+#include <string.h>
+
+long statecopy(char* p, void* v, long n, int8_t s) {
+  if (p) {
+    if (s) memcpy(p, v, n); else memcpy(v, p, n);
+  }
+  return n;
+}
+
+/* the macro is local to iocontext() */
+#define IOSTATE(v) n += statecopy(p ? p + n : 0, &(v), sizeof(v), s)
+long iocontext(char* p, int8_t s) {
+  long n = 0;
+
+  IOSTATE(id);
+  IOSTATE(od);
+  IOSTATE(idd);
+  IOSTATE(odd);
+  IOSTATE(ioer);
+  IOSTATE(sendcr);
+  IOSTATE(blockmode);
+#ifdef HASSERVER
+  IOSTATE(consline);
+  IOSTATE(conslinen);
+#endif
+#ifdef HASMSTAB
+  IOSTATE(charcount);
+#endif
+  IOSTATE(ifile);
+  IOSTATE(ofile);
+  IOSTATE(root);
+  IOSTATE(file);
+  return n;
+}
+#undef IOSTATE
+#endif
+
+/* 
+ * The thread pool of the server mode. Each thread has a queue of jobs, 
+ * it runs the first job for one slice with poolstep() and appends it 
+ * again as long as poolstep() returns 1. A thread with an empty queue 
+ * steals from the end of the other queues. The CPU time of each job is 
+ * measured with the thread clock and added to poolcputime[] in us. 
+ */
+#ifdef HASSERVER
+#include <pthread.h>
+#include <sched.h>
+
+typedef struct {
+  int* job;
+  int head;
+  int n;
+  pthread_mutex_t lock;
+} poolqueue_t;
+
+poolqueue_t* poolqueue;
+int poolthreads;
+int pooljobs;
+volatile int poolremaining;
+void** pooljob;
+unsigned long* poolcputime;
+uint8_t (*poolstep)(void*);
+
+void poolpush(int q, int j) {
+  poolqueue_t* p = &poolqueue[q];
+
+  pthread_mutex_lock(&p->lock);
+  p->job[(p->head + p->n++) % pooljobs] = j;
+  pthread_mutex_unlock(&p->lock);
+}
+
+/* take the first job of a queue or steal the last, -1 if empty */
+int poolpop(int q, uint8_t steal) {
+  poolqueue_t* p = &poolqueue[q];
+  int j = -1;
+
+  pthread_mutex_lock(&p->lock);
+  if (p->n > 0) {
+    if (steal) {
+      j = p->job[(p->head + p->n - 1) % pooljobs];
+    } else {
+      j = p->job[p->head];
+      p->head = (p->head + 1) % pooljobs;
+    }
+    p->n--;
+  }
+  pthread_mutex_unlock(&p->lock);
+  return j;
+}
+
+void* poolworker(void* a) {
+  int q = (int)(long) a;
+  int j, k;
+  uint8_t r;
+  struct timespec t0, t1;
+
+  while (poolremaining > 0) {
+    j = poolpop(q, 0);
+    for (k = 1; j < 0 && k < poolthreads; k++) j = poolpop((q + k) % poolthreads, 1);
+    if (j < 0) {
+      sched_yield();
+      continue;
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+    r = poolstep(pooljob[j]);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+    poolcputime[j] += (t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_nsec - t0.tv_nsec) / 1000;
+    if (r) poolpush(q, j); else __sync_fetch_and_sub(&poolremaining, 1);
+  }
+  return 0;
+}
+
+/* run n jobs on t threads until all are done, 1 on success */
+uint8_t poolrun(void** job, int n, int t, uint8_t (*step)(void*), unsigned long* cputime) {
+  pthread_t* thread;
+  int i;
+  uint8_t r = 0;
+
+  if (n <= 0 || t <= 0) return 0;
+  pooljob = job;
+  pooljobs = n;
+  poolremaining = n;
+  poolthreads = t;
+  poolstep = step;
+  poolcputime = cputime;
+  for (i = 0; i < n; i++) cputime[i] = 0;
+
+  poolqueue = (poolqueue_t*) calloc(t, sizeof(poolqueue_t));
+  thread = (pthread_t*) calloc(t, sizeof(pthread_t));
+  if (!poolqueue || !thread) goto done;
+  for (i = 0; i < t; i++) {
+    poolqueue[i].job = (int*) malloc(n * sizeof(int));
+    if (!poolqueue[i].job) goto done;
+    pthread_mutex_init(&poolqueue[i].lock, 0);
+  }
+
+  /* deal the jobs round robin */
+  for (i = 0; i < n; i++) poolpush(i % t, i);
+
+  for (i = 0; i < t; i++) pthread_create(&thread[i], 0, poolworker, (void*)(long) i);
+  for (i = 0; i < t; i++) pthread_join(thread[i], 0);
+  r = 1;
+
+done:
+  if (poolqueue) for (i = 0; i < t; i++) free(poolqueue[i].job);
+  free(poolqueue);
+  free(thread);
+  poolqueue = 0;
+  return r;
+}
+#endif
+
 /* the buildin file system for ro access - transfered and simplified from the Arduino runtime.cpp */
 #ifdef HASBUILDIN
 char* buildin_ifile = 0;
@@ -1337,7 +2976,7 @@ void ifileclose(){
     buildin_ifilepointer=0;   
   }
 #endif
-  if (ifile) fclose(ifile);
+  if (ifile && ifile != ofile) fclose(ifile);
   ifile=0;  
 }
 
@@ -1347,10 +2986,20 @@ uint8_t ofileopen(const char* filename, const char* m){
 }
 
 void ofileclose(){ 
-  if (ofile) fclose(ofile); 
+  if (ofile && ofile != ifile) fclose(ofile); 
   ofile=0;
 }
 
+/* random access, one stream is the input and the output file */
+uint8_t rfileopen(const char* filename){
+  ifileclose();
+  ofileclose();
+  ofile=fopen(filename, "r+");
+  if (!ofile) ofile=fopen(filename, "w+");
+  ifile=ofile;
+  return ofile!=0;
+}
+
 int fileavailable(){ 
 #if defined(HASBUILDIN)
   if (buildin_ifile) {
@@ -1360,6 +3009,39 @@ int fileavailable(){
   return !feof(ifile); 
 }
 
+/*
+ * Binary block access and positioning for the record I/O, 
+ * the buildin files are text only and cannot be used here.
+ */
+uint16_t fileblockread(char* b, uint16_t n) {
+#if defined(HASBUILDIN)
+  if (buildin_ifile) { ioer=1; return 0; }
+#endif
+  if (ifile) return fread(b, 1, n, ifile); else { ioer=1; return 0; }
+}
+
+uint16_t fileblockwrite(char* b, uint16_t n) {
+  if (ofile) return fwrite(b, 1, n, ofile); else { ioer=1; return 0; }
+}
+
+uint8_t ifileseek(unsigned long p) {
+#if defined(HASBUILDIN)
+  if (buildin_ifile) return 0;
+#endif
+  if (ifile) return fseek(ifile, p, SEEK_SET) == 0; else return 0;
+}
+
+unsigned long ifiletell() {
+#if defined(HASBUILDIN)
+  if (buildin_ifile) return buildin_ifilepointer;
+#endif
+  if (ifile) return ftell(ifile); else return 0;
+}
+
+uint8_t ofileseek(unsigned long p) {
+  if (ofile) return fseek(ofile, p, SEEK_SET) == 0; else return 0;
+}
+
 /*
  * directory handling for the catalog function
  * these methods are needed for a walkthtrough of 
@@ -1492,7 +3174,7 @@ void bufferbegin() {}
 /* write to the buffer, works only until 127 
   uses vt52 style commands to handle the buffer content*/
 void bufferwrite(char c) {
-  if (!nullbuffer) return;
+  if (!nullbuffer) nullbuffer = ibuffer;
   switch (c) {
   case 12: /* clear screen */
     //nullbuffer[nullbuffer[0]+1]=0;
@@ -1521,6 +3203,144 @@ char buffercheckch() { return 0; }
 void bufferflush() { }
 uint16_t bufferins(char *b, uint16_t nb) { return 0; }
 
+/*
+ * The Posix event loop. The console and the printer port are 
+ * polled with poll() and read into ring buffers. Checking and 
+ * availability of characters are memory reads then. If a ring 
+ * is empty, a non blocking poll is done at most once every 
+ * millisecond. Files are always ready for poll() and are read 
+ * directly. 
+ */
+#ifdef POSIXEVENTLOOP
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+
+typedef struct {
+  char buffer[IORINGSIZE];
+  uint16_t head;
+  uint16_t tail;
+  uint8_t eof;
+} ioring_t;
+
+ioring_t consring;
+uint8_t consterminal = 0;
+uint32_t lastpoll = 0;
+
+#ifdef POSIXPRT
+ioring_t prtring;
+extern int prtfile;
+#endif
+
+/* the characters in a ring */
+uint16_t ringavailable(ioring_t* r) { 
+  return (r->tail + IORINGSIZE - r->head) % IORINGSIZE; 
+}
+
+/* take one character from a ring, only call if there is one */
+char ringread(ioring_t* r) {
+  char c = r->buffer[r->head];
+  r->head = (r->head + 1) % IORINGSIZE;
+  return c;
+}
+
+/* read what a descriptor has into the free part of a ring, 0 bytes is EOF on the console */
+void ringfill(ioring_t* r, int fd) {
+  char b[IORINGSIZE];
+  int n, i;
+
+  n = IORINGSIZE - 1 - ringavailable(r);
+  if (n == 0) return;
+  n = read(fd, b, n);
+  if (n == 0 && fd == 0) r->eof = 1;
+  for (i = 0; i < n; i++) {
+    r->buffer[r->tail] = b[i];
+    r->tail = (r->tail + 1) % IORINGSIZE;
+  }
+}
+
+/* poll all descriptors and wait at most t milliseconds for one of them */
+void iopoll(int t) {
+  struct pollfd fds[2];
+  int n = 0;
+
+  if (!consring.eof) {
+    fds[n].fd = 0;
+    fds[n++].events = POLLIN;
+  }
+#ifdef POSIXPRT
+  if (prtfile > 0) {
+    fds[n].fd = prtfile;
+    fds[n++].events = POLLIN;
+  }
+#endif
+  lastpoll = millis();
+  if (n == 0 || poll(fds, n, t) <= 0) return;
+
+  while (n-- > 0) {
+    if (!(fds[n].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+    if (fds[n].fd == 0) ringfill(&consring, 0);
+#ifdef POSIXPRT
+    else ringfill(&prtring, prtfile);
+#endif
+  }
+}
+
+/* poll without waiting, at most once per millisecond */
+void iocheck() {
+  if (millis() != lastpoll) iopoll(0);
+}
+
+/* BREAKCHAR is only for the keyboard, piped input is data */
+void serialbegin() {
+  consterminal = isatty(0);
+}
+
+/* wait for a character, background tasks keep running */
+char serialread() { 
+  while (!ringavailable(&consring)) {
+    if (consring.eof) return -1;
+    iopoll(YIELDINTERVAL);
+    byield();
+  }
+  return ringread(&consring);
+}
+
+/* look at the next character */
+char serialcheckch() {
+  if (!consterminal) return 0;
+  if (!ringavailable(&consring)) iocheck();
+  if (ringavailable(&consring)) return consring.buffer[consring.head]; 
+  return 0;
+}
+
+/* the number of characters buffered */
+uint16_t serialavailable() { 
+  if (!ringavailable(&consring)) iocheck();
+  return ringavailable(&consring);
+}
+
+/* is there an entire line, wait at most t milliseconds for it */
+uint8_t serialline(uint16_t t) {
+  uint16_t i;
+
+  for (;;) {
+    if (consring.eof || ringavailable(&consring) == IORINGSIZE - 1) return 1;
+    for (i = consring.head; i != consring.tail; i = (i + 1) % IORINGSIZE)
+      if (consring.buffer[i] == '\n') return 1;
+    if (t == 0) return 0;
+    iopoll(t);
+    t = 0;
+  }
+}
+
+/* throw away everything that was typed */
+void serialflush() {
+  iopoll(0);
+  consring.head = consring.tail;
+}
+
+#elif defined(POSIXNONBLOCKING)
 /*
  * Primary serial code, if NONBLOCKING is set, 
  * platform dependent I/O is used. This means that 
@@ -1529,7 +3349,6 @@ uint16_t bufferins(char *b, uint16_t nb) { return 0; }
  * This serves only to interrupt programs with 
  * BREAKCHAR at the moment. 
  */
-#ifdef POSIXNONBLOCKING
 #if !defined(MSDOS) && !defined(MINGW)
 #include <fcntl.h>
 
@@ -1830,6 +3649,15 @@ uint16_t serialins(char* b, uint16_t nb) {
 
 void serialwrite(char c) { 
 
+/* in server mode the output goes to the line buffer untranslated */
+#ifdef HASSERVER
+  if (conslines) {
+    consline[conslinen++] = c;
+    if (c == '\n' || conslinen == CONSLINESIZE) consflush();
+    return;
+  }
+#endif
+
 /* the vt52 state engine */
 #ifdef POSIXVT52TOANSI
   if (dspesc) { 
@@ -1872,6 +3700,13 @@ void serialwrite(char c) {
  * 
  * Tried to learn from https://www.pololu.com/docs/0J73/15.5
  *
+ * The port is opened in raw mode with the baudrate given in OPEN or 
+ * set with SET 8. Output is collected in a buffer and written in blocks 
+ * by prtflush(), after a newline, when the buffer is full, before a read 
+ * and after every statement in yieldschedule(). With the event loop, input 
+ * comes from the ring buffer filled by poll(). 
+ *
+ * A pseudo terminal pair from openpty() can stand in for the hardware.
  */
 #ifdef POSIXPRT
 #include <fcntl.h>
@@ -1885,46 +3720,89 @@ int prtfile;
 /* the buffer to read one character */
 char prtbuf = 0;
 
+/* the output buffer and the baudrate */
+char prtobuffer[PRTBUFSIZE];
+uint16_t prtobufn = 0;
+uint32_t prt_baudrate = 9600;
 
 void prtbegin() {}
 
-char prtopen(char* filename, uint16_t mode) {
 #if !defined(MSDOS) && !defined(MINGW)
+/* map a baudrate to the termios constant, unknown rates are 9600 */
+speed_t prtspeed(uint32_t baud) {
+  switch (baud) {
+    case 300: return B300;
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B500000
+    case 500000: return B500000;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B1000000
+    case 1000000: return B1000000;
+#endif
+#ifdef B2000000
+    case 2000000: return B2000000;
+#endif
+    default: return B9600;
+  }
+}
+#endif
+
+char prtopen(char* filename, uint32_t mode) {
+#if !defined(MSDOS) && !defined(MINGW)
+  struct termios opt;
+  int flags = O_RDWR | O_NOCTTY;
+
+/* with the event loop the port is non blocking, poll() does the waiting */
+#ifdef POSIXEVENTLOOP
+  flags |= O_NONBLOCK;
+#endif
 
 /* try to open the device file */
-  prtfile=open(filename, O_RDWR | O_NOCTTY);
+  prtfile=open(filename, flags);
   if (prtfile == -1) {
     perror(filename);
+    prtfile = 0;
     return 0;
   } 
 
 /* get rid of garbage */
   tcflush(prtfile, TCIOFLUSH);
+  prtobufn = 0;
+#ifdef POSIXEVENTLOOP
+  prtring.head = prtring.tail = 0;
+#endif
 
 /* configure the device */
-  struct termios opt;
   (void) tcgetattr(prtfile, &opt);
 
-
-/* raw terminal settings
-  opt.c_iflag &= ~(INLCR | IGNCR | ICRNL | IXON | IXOFF);
-  opt.c_oflag &= ~(ONLCR | OCRNL);
+/* raw terminal settings, 8 bit, no parity, no flow control */
+  opt.c_iflag &= ~(INLCR | IGNCR | ICRNL | IXON | IXOFF | ISTRIP | BRKINT | PARMRK | INPCK);
+  opt.c_oflag &= ~(ONLCR | OCRNL | OPOST);
   opt.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
-*/
+  opt.c_cflag &= ~(CSIZE | PARENB | CSTOPB);
+  opt.c_cflag |= CS8 | CLOCAL | CREAD;
 
 /* timeout settings on read 100ms, read every character */
   opt.c_cc[VTIME] = 1;
   opt.c_cc[VMIN] = 0;
 
 /* set the baudrate */
-  switch (mode) {
-    case 9600: 
-      cfsetospeed(&opt, B9600);
-      break;
-    default:
-      cfsetospeed(&opt, B9600);
-      break;
-  }
+  prt_baudrate = mode;
+  cfsetospeed(&opt, prtspeed(mode));
   cfsetispeed(&opt, cfgetospeed(&opt));
 
 /* set the termin attributes */
@@ -1935,23 +3813,116 @@ char prtopen(char* filename, uint16_t mode) {
 }
 
 void prtclose() {
-  if (prtfile) close(prtfile);
+  prtflush();
+  if (prtfile > 0) close(prtfile);
+  prtfile = 0;
+}
+
+/* the status is the baudrate in 1000 baud like on the serial port, 16 bit as 460800 and up don't fit a byte */
+uint16_t prtstat(uint8_t c) {
+  if (c == 0) return 1;
+  if (c == 1) return prt_baudrate/1000;
+  return 0;
 }
 
-uint8_t prtstat(uint8_t c) {return 1; }
+/* change the baudrate of an open port */
+void prtset(uint32_t s) {
+#if !defined(MSDOS) && !defined(MINGW)
+  struct termios opt;
 
-void prtset(uint32_t s) {}
+  prt_baudrate = s;
+  if (prtfile <= 0) return;
+  prtflush();
+  (void) tcgetattr(prtfile, &opt);
+  cfsetospeed(&opt, prtspeed(s));
+  cfsetispeed(&opt, cfgetospeed(&opt));
+  tcsetattr(prtfile, TCSADRAIN, &opt);
+#endif
+}
+
+/* write the output buffer, a non blocking port waits until it can write */
+void prtflush() {
+  uint16_t i = 0;
+  int n;
+
+  while (i < prtobufn && prtfile > 0) {
+    n = write(prtfile, prtobuffer + i, prtobufn - i);
+    if (n > 0) {
+      i += n;
+      continue;
+    }
+#ifdef POSIXEVENTLOOP
+    if (n < 0 && errno == EAGAIN) {
+      struct pollfd fds;
+      fds.fd = prtfile;
+      fds.events = POLLOUT;
+      if (poll(&fds, 1, 100) > 0) continue;
+    }
+#endif
+    ioer = 1;
+    break;
+  }
+  prtobufn = 0;
+}
 
-/* write the characters byte by byte */
+/* collect the characters, lines are written at once */
 void prtwrite(char c) {
-  int i=write(prtfile, &c, 1);
-  if (i != 1) ioer=1;
+  prtobuffer[prtobufn++] = c;
+  if (c == '\n' || prtobufn == PRTBUFSIZE) prtflush();
 }
 
 /* read just one byte, map no bytes to EOF = -1 */
+#ifdef POSIXEVENTLOOP
+/* from the ring, wait 100ms like the VTIME setting if it is empty */
+char prtread() {
+  if (prtobufn) prtflush();
+  if (!ringavailable(&prtring)) iopoll(100);
+  if (!ringavailable(&prtring)) return -1;
+  return ringread(&prtring);
+}
+
+char prtcheckch(){ 
+  if (prtobufn) prtflush();
+  if (!ringavailable(&prtring)) iocheck();
+  if (ringavailable(&prtring)) return prtring.buffer[prtring.head];
+  return 0;
+}
+
+uint16_t prtavailable(){ 
+  if (prtobufn) prtflush();
+  if (!ringavailable(&prtring)) iocheck();
+  return ringavailable(&prtring);
+}
+
+/* 
+ * block mode 1 takes what is in the ring, block mode n waits n ms 
+ * for more, line mode reads character by character from the ring 
+ */
+uint16_t prtins(char* b, uint16_t nb) {
+  uint16_t z = 0;
+  uint32_t m;
+
+  if (blockmode == 0) return consins(b, nb);
+
+  if (prtobufn) prtflush();
+  m = millis();
+  for (;;) {
+    if (!ringavailable(&prtring)) iocheck();
+    while (z < nb - 1 && ringavailable(&prtring)) b[++z] = ringread(&prtring);
+    if (z == nb - 1 || blockmode == 1) break;
+    if (millis() - m > blockmode) break;
+    iopoll(blockmode - (millis() - m));
+  }
+  b[0] = (unsigned char) z;
+  b[z + 1] = 0;
+  return z;
+}
+#else
 char prtread() {
   char c;
 
+  if (prtobufn) prtflush();
+
 /* something in the buffer? return it! */
   if (prtbuf) {
     c=prtbuf;
@@ -1982,12 +3953,15 @@ uint16_t prtavailable(){
 }
 
 uint16_t prtins(char* b, uint16_t nb) {
+    if (prtobufn) prtflush();
     if (blockmode > 0) return inb(b, nb); else return consins(b, nb);
 }
+#endif
 
 #else
 void prtbegin() {}
-uint8_t prtstat(uint8_t c) {return 0; }
+void prtflush() {}
+uint16_t prtstat(uint8_t c) {return 0; }
 void prtset(uint32_t s) {}
 void prtwrite(char c) {}
 char prtread() {return 0;}
@@ -2173,33 +4147,259 @@ void detachinterrupt(uint8_t pin) {}
 /*
  * Experimental code to simulate 64kb SPI SRAM modules
  * 
- * currently used to test the string code of the mem 
- * interface
- *
+ * The simulator runs the same page cache as the Arduino code on 
+ * top of a plain array. Every access to the array is counted 
+ * like an SPI transaction with 3 bytes of command and address. 
+ * spiramstat() reports the counters to benchmark cache policies.
  */
 
 #ifdef SPIRAMSIMULATOR
 
 static int8_t spiram[65536];
 
-/* the RAM begin method sets the RAM to byte mode */
+/* the counters of the simulated bus and the cache */
+unsigned long spiram_transactions = 0;
+unsigned long spiram_bytes = 0;
+unsigned long spiram_hits = 0;
+unsigned long spiram_misses = 0;
+unsigned long spiram_writebacks = 0;
+
+/* the page cache, a line is a page, the lines of a set are consecutive */
+#define SPIRAMLINES (SPIRAMSETS * SPIRAMWAYS)
+int8_t spiram_cache[SPIRAMLINES][SPIRAMPAGESIZE];
+uint16_t spiram_cachepage[SPIRAMLINES];
+uint8_t spiram_cacheage[SPIRAMLINES];
+uint8_t spiram_cacheflags[SPIRAMLINES]; /* 1 is valid, 2 is dirty */
+uint16_t spiram_lastline = 0;
+uint16_t spiram_ropage = 0xffff;
+
+/* the RAM begin method sets the RAM to byte mode and clears the cache */
 uint16_t spirambegin() {
+  uint16_t i;
+
+  for (i = 0; i < SPIRAMLINES; i++) {
+    spiram_cacheflags[i] = 0;
+    spiram_cacheage[i] = i % SPIRAMWAYS;
+  }
   return 65534;
 }
 
-/* the simple unbuffered byte write, with a cast to signed char */
-void spiramrawwrite(uint16_t a, int8_t c) {spiram[a]=c;}
+/* the elementary transactions, l bytes from or to the chip */
+void spiram_bufferread(uint16_t a, int8_t* b, uint16_t l) {
+  spiram_transactions++;
+  spiram_bytes += 3 + l;
+  while (l--) *b++ = spiram[a++];
+}
+
+void spiram_bufferwrite(uint16_t a, int8_t* b, uint16_t l) {
+  spiram_transactions++;
+  spiram_bytes += 3 + l;
+  while (l--) spiram[a++] = *b++;
+}
+
+/* read two pages in one sequential transaction, the second is the prefetch */
+void spiram_pagesread(uint16_t a, int8_t* b1, int8_t* b2) {
+  uint16_t i;
+
+  spiram_transactions++;
+  spiram_bytes += 3 + 2 * SPIRAMPAGESIZE;
+  for (i = 0; i < SPIRAMPAGESIZE; i++) b1[i] = spiram[a++];
+  for (i = 0; i < SPIRAMPAGESIZE; i++) b2[i] = spiram[a++];
+}
+
+/* find the line of a page, -1 if it is not cached */
+int16_t spiram_find(uint16_t p) {
+  uint16_t i, s = (p % SPIRAMSETS) * SPIRAMWAYS;
+
+  for (i = s; i < s + SPIRAMWAYS; i++) 
+    if ((spiram_cacheflags[i] & 1) && spiram_cachepage[i] == p) return i;
+  return -1;
+}
+
+/* make a line the most recently used of its set */
+void spiram_touch(uint16_t l) {
+  uint16_t i, s = l - l % SPIRAMWAYS;
+
+  for (i = s; i < s + SPIRAMWAYS; i++) 
+    if (spiram_cacheage[i] < spiram_cacheage[l]) spiram_cacheage[i]++;
+  spiram_cacheage[l] = 0;
+  spiram_lastline = l;
+}
+
+/* free a line for page p, an empty one or the least recently used */
+uint16_t spiram_victim(uint16_t p) {
+  uint16_t i, l, s = (p % SPIRAMSETS) * SPIRAMWAYS;
+
+  l = s;
+  for (i = s; i < s + SPIRAMWAYS; i++) {
+    if (!(spiram_cacheflags[i] & 1)) { l = i; break; }
+    if (spiram_cacheage[i] > spiram_cacheage[l]) l = i;
+  }
+  if (spiram_cacheflags[l] & 2) {
+    spiram_bufferwrite(spiram_cachepage[l] * SPIRAMPAGESIZE, spiram_cache[l], SPIRAMPAGESIZE);
+    spiram_writebacks++;
+  }
+  spiram_cacheflags[l] = 0;
+  return l;
+}
+
+/* 
+ * load page p into the cache, with prefetch the next page comes 
+ * with it in the same transaction if it is not yet cached 
+ */
+uint16_t spiram_load(uint16_t p, uint8_t prefetch) {
+  uint16_t l;
+#ifdef SPIRAMPREFETCH
+  uint16_t m;
+#endif
+
+  spiram_misses++;
+  l = spiram_victim(p);
+  spiram_cachepage[l] = p;
+  spiram_cacheflags[l] = 1;
+  spiram_touch(l);
+#ifdef SPIRAMPREFETCH
+  if (prefetch && SPIRAMLINES > 1 && p + 1 < 65536 / SPIRAMPAGESIZE && spiram_find(p + 1) < 0) {
+    m = spiram_victim(p + 1);
+    spiram_pagesread(p * SPIRAMPAGESIZE, spiram_cache[l], spiram_cache[m]);
+    spiram_cachepage[m] = p + 1;
+    spiram_cacheflags[m] = 1;
+    spiram_touch(m);
+    spiram_touch(l);
+    return l;
+  }
+#endif
+  spiram_bufferread(p * SPIRAMPAGESIZE, spiram_cache[l], SPIRAMPAGESIZE);
+  return l;
+}
+
+/* the line of an address, loaded if needed */
+uint16_t spiram_line(uint16_t a, uint8_t prefetch) {
+  uint16_t p = a / SPIRAMPAGESIZE;
+  int16_t l;
+
+  if ((spiram_cacheflags[spiram_lastline] & 1) && spiram_cachepage[spiram_lastline] == p) {
+    spiram_hits++;
+    return spiram_lastline;
+  }
+  if ((l = spiram_find(p)) < 0) return spiram_load(p, prefetch);
+  spiram_hits++;
+  spiram_touch(l);
+  return l;
+}
+
+/* the simple unbuffered byte write, the cache keeps its copy current */
+void spiramrawwrite(uint16_t a, int8_t c) {
+  int16_t l = spiram_find(a / SPIRAMPAGESIZE);
+
+  spiram_transactions++;
+  spiram_bytes += 4;
+  spiram[a] = c;
+  if (l >= 0) spiram_cache[l][a % SPIRAMPAGESIZE] = c;
+}
+
+/* the simple unbuffered byte read, a dirty page is newer than the chip */
+int8_t spiramrawread(uint16_t a) {
+  int16_t l = spiram_find(a / SPIRAMPAGESIZE);
+
+  if (l >= 0) return spiram_cache[l][a % SPIRAMPAGESIZE];
+  spiram_transactions++;
+  spiram_bytes += 4;
+  return spiram[a];
+}
+
+/* the token stream, prefetches if it moves to the next page */
+int8_t spiram_robufferread(uint16_t a) {
+  uint16_t p = a / SPIRAMPAGESIZE;
+  uint16_t l = spiram_line(a, p == spiram_ropage + 1);
 
-/* the simple unbuffered byte read, with a cast to signed char */
-int8_t spiramrawread(uint16_t a) {return spiram[a];}
+  spiram_ropage = p;
+  return spiram_cache[l][a % SPIRAMPAGESIZE];
+}
+
+/* the heap and the program editor */
+int8_t spiram_rwbufferread(uint16_t a) {
+  return spiram_cache[spiram_line(a, 0)][a % SPIRAMPAGESIZE];
+}
+
+void spiram_rwbufferwrite(uint16_t a, int8_t c) {
+  uint16_t l = spiram_line(a, 0);
+
+  spiram_cache[l][a % SPIRAMPAGESIZE] = c;
+  spiram_cacheflags[l] |= 2;
+}
+
+/* 
+ * block access, bytes of cached pages come from the cache, runs of 
+ * uncached pages go to the chip in one transaction without loading them 
+ */
+void spiram_blockread(uint16_t a, int8_t* b, uint16_t l) {
+  uint16_t i, n, r = 0;
+  int16_t c;
+
+  while (l > 0) {
+    n = SPIRAMPAGESIZE - a % SPIRAMPAGESIZE;
+    if (n > l) n = l;
+    if ((c = spiram_find(a / SPIRAMPAGESIZE)) >= 0) {
+      if (r) { spiram_bufferread(a - r, b - r, r); r = 0; }
+      for (i = 0; i < n; i++) b[i] = spiram_cache[c][a % SPIRAMPAGESIZE + i];
+      spiram_hits++;
+    } else r += n;
+    a += n; b += n; l -= n;
+  }
+  if (r) spiram_bufferread(a - r, b - r, r);
+}
 
-/* the buffers calls, also only simulated here */
+void spiram_blockwrite(uint16_t a, int8_t* b, uint16_t l) {
+  uint16_t i, n, r = 0;
+  int16_t c;
+
+  while (l > 0) {
+    n = SPIRAMPAGESIZE - a % SPIRAMPAGESIZE;
+    if (n > l) n = l;
+    if ((c = spiram_find(a / SPIRAMPAGESIZE)) >= 0) {
+      if (r) { spiram_bufferwrite(a - r, b - r, r); r = 0; }
+      for (i = 0; i < n; i++) spiram_cache[c][a % SPIRAMPAGESIZE + i] = b[i];
+      spiram_cacheflags[c] |= 2;
+      spiram_hits++;
+    } else r += n;
+    a += n; b += n; l -= n;
+  }
+  if (r) spiram_bufferwrite(a - r, b - r, r);
+}
 
-void spiram_rwbufferwrite(uint16_t a, int8_t c) {spiram[a]=c;}
+/* write all dirty pages back to the chip */
+void spiram_rwbufferflush() {
+  uint16_t i;
 
-int8_t spiram_rwbufferread(uint16_t a) {return spiram[a];}
+  for (i = 0; i < SPIRAMLINES; i++) {
+    if (spiram_cacheflags[i] & 2) {
+      spiram_bufferwrite(spiram_cachepage[i] * SPIRAMPAGESIZE, spiram_cache[i], SPIRAMPAGESIZE);
+      spiram_writebacks++;
+      spiram_cacheflags[i] &= 1;
+    }
+  }
+}
 
-int8_t spiram_robufferread(uint16_t a) {return spiram[a];}
+/* 
+ * the counters, 0 transactions, 1 bytes, 2 cache hits, 3 misses, 
+ * 4 written back pages, 5 the estimated bus time in us, 6 resets 
+ */
+unsigned long spiramstat(uint8_t c) {
+  switch (c) {
+  case 0: return spiram_transactions;
+  case 1: return spiram_bytes;
+  case 2: return spiram_hits;
+  case 3: return spiram_misses;
+  case 4: return spiram_writebacks;
+  case 5: return spiram_transactions * SPIRAMOVERHEAD + spiram_bytes * 8 / SPIRAMCLOCK;
+  case 6: 
+    spiram_transactions = spiram_bytes = 0;
+    spiram_hits = spiram_misses = spiram_writebacks = 0;
+    return 0;
+  }
+  return 0;
+}
 
 /* to handle strings in SPIRAM situations two more buffers are needed 
  * they store intermediate results of string operations. The buffersize 
@@ -105,11 +105,11 @@
  * odd: the default output device in interactive mode
  * ioer: the io error   
  */
-extern int8_t id; 
-extern int8_t od; 
-extern int8_t idd;
-extern int8_t odd;
-extern int8_t ioer;
+extern BSTATE int8_t id; 
+extern BSTATE int8_t od; 
+extern BSTATE int8_t idd;
+extern BSTATE int8_t odd;
+extern BSTATE int8_t ioer;
 
 /* 
  * Io control flags.
@@ -122,17 +122,17 @@ extern int8_t ioer;
  */
 
 extern uint8_t kbdrepeat;
-extern uint8_t blockmode;
-extern uint8_t sendcr;
+extern BSTATE uint8_t blockmode;
+extern BSTATE uint8_t sendcr;
 
 /* breaks, signaly back that the breakcondition has been detected */
-extern char breakcondition;
+extern BSTATE char breakcondition;
 
 /* counts the outputed characters on streams 0-4, used to emulate a real tab */
-extern uint8_t charcount[5]; /* devices 0-4 support tabing */
+extern BSTATE uint8_t charcount[5]; /* devices 0-4 support tabing */
 
 /* the memory buffer comes from BASIC in this version, it is the input buffer for lines */
-extern char ibuffer[BUFSIZE];
+extern BSTATE char ibuffer[BUFSIZE];
 
 /* only needed in POSIX worlds */
 extern uint8_t breaksignal; 
@@ -163,6 +163,28 @@ extern char mqtt_otopic[MQTTLENGTH];
 extern char mqtt_itopic[MQTTLENGTH];
 extern char mqttname[];
 
+/* 
+ * Interpreter contexts, with HASCONTEXTS the interpreter state is thread 
+ * local and can be copied to a buffer and back.
+ *
+ * statecopy(p, v, n, s): copy n bytes of v to p if s is 1, back if s is 0
+ * iocontext(p, s): the same for the runtime state of an interpreter
+ * Both return the number of bytes, p == 0 only counts.
+ */
+#ifdef HASCONTEXTS
+long statecopy(char*, void*, long, int8_t);
+long iocontext(char*, int8_t);
+#endif
+
+/* 
+ * The thread pool of the server mode, poolrun(jobs, n, t, step, cputime)
+ * runs n jobs on t threads. step(job) runs one slice of a job and returns 
+ * 1 if the job needs more time. cputime gets the CPU time of each job in us.
+ */
+#ifdef HASSERVER
+uint8_t poolrun(void**, int, int, uint8_t (*)(void*), unsigned long*);
+#endif
+
 /* a byte in the runtime memory containing the system type */
 extern uint8_t bsystype;
 
@@ -335,6 +357,8 @@ int  avgfastticker();
  * elength() returns the length of the EEPROM.
  * eupdate() updates one EEPROM cell with a value. Does not flush. 
  * eread() reads one EEPROM cell.
+ * eaddress() is the EEPROM in memory if it can be read directly, 0 if not.
+ *    Programs stored there are run in place.
  */ 
 
 void ebegin(); 
@@ -342,6 +366,7 @@ void eflush();
 uint16_t elength();
 void eupdate(uint16_t, int8_t);
 int8_t eread(uint16_t);
+int8_t* eaddress();
 
 /* 
  *  The wrappers of the arduino io functions.
@@ -459,6 +484,7 @@ typedef int PinStatus;
   * serialavailable(): check if characters are available
   * serialflush(): flush the serial port
   * serialins(s, l): read a line from the serial port
+  * serialline(t): is an entire line buffered, waits t ms, only with POSIXEVENTLOOP
   */
  
  void serialbegin();
@@ -469,14 +495,22 @@ typedef int PinStatus;
  uint16_t serialavailable(); /* avail method, needed for AVAIL() */ 
  void serialflush(); /* flush serial */
  uint16_t serialins(char*, uint16_t); /* read a line from serial */
+#ifdef POSIXEVENTLOOP
+ uint8_t serialline(uint16_t); /* wait for a line, for timers during INPUT */
+#endif
  
  /*
   * reading from the console with inch or the picoserial callback.
   * consins() is used for all devices that have a character oriented
   * input and creates entire lines from it.
+  * consflush() writes the console line buffer of the server mode.
   */
 
  uint16_t consins(char *, uint16_t);
+ void consflush();
+#ifdef HASSERVER
+ extern uint8_t conslines;
+#endif
 
 /* 
  * On Arduino Serial is a big object that needs a lot of memory 
@@ -741,7 +775,10 @@ void dspsetscrollmode(uint8_t, uint8_t);
 
 void dspbufferclear(); 
 void dspscroll(uint8_t, uint8_t); 
-void dspreversescroll(uint8_t); 
+void dspreversescroll(uint8_t);
+
+/* the counters of the headless Posix display */
+unsigned long dspcounter(uint8_t); 
 
 /*
  * A VT52 state engine is implemented and works for buffered and 
@@ -793,6 +830,9 @@ void vgascale(int*, int*);
 void vgawrite(char); 
 void vgaend();
 
+/* the Posix framebuffer writes its back buffer to a PPM file */
+void vgadump(const char*);
+
 /* 
  * IO channel 2 (input) - the keyboard I/O device.
  *
@@ -842,7 +882,7 @@ uint16_t kbdins(char*, uint16_t);
   * 
   * prtbegin(): start the serial port
   * prtopen(name, baud): open the serial port with the baud rate baud. Only 
-  *  neded in POSIX to open the port.
+  *  neded in POSIX to open the port, raw mode and buffered output there.
   * prtclose(): close the serial port
   * prtstat(s): check the status of the serial port
   * prtwrite(c): write a character to the serial port
@@ -851,18 +891,20 @@ uint16_t kbdins(char*, uint16_t);
   * prtavailable(): check if characters are available
   * prtset(baud): set the baud rate of the serial port
   * prtins(s, l): read a line from the serial port
+  * prtflush(): write buffered output, only buffered on POSIX
   */
  
   void prtbegin();
-  char prtopen(char*, uint16_t); 
+  char prtopen(char*, uint32_t); 
   void prtclose();
-  uint8_t prtstat(uint8_t);
+  uint16_t prtstat(uint8_t);
   void prtwrite(char);
   char prtread();
   char prtcheckch();
   uint16_t prtavailable();
   void prtset(uint32_t);
   uint16_t prtins(char*, uint16_t);
+  void prtflush();
 
 /* 
  * IO channel 7 - I2C through the Wire library.
@@ -987,10 +1029,13 @@ int16_t wirereadbyte();
   * The mqtt prototypes used by BASIC are:
   * 
   * mqttbegin(): start the mqtt client
+  * mqttloop(): poll the connection, send batched packets and keep it alive
+  * mqttset(q): set the QoS 0 or 1 of publish and subscribe
   * mqttsetname(): set the name of the mqtt client. The name is autogenerated.
   * mqttstat(s): check the status of the mqtt client
   * mqttreconnect(): reconnect the mqtt client
-  * mqttstate(): get the state of the mqtt client (redunant to mqttstat())
+  * mqttstate(): get the state of the mqtt client (redunant to mqttstat()), 
+  *  the errors are negative, both return an int for this reason
   * mqttsubscribe(t): subscribe to a topic
   * mqttunsubscribe(): unsubscribe from a topic
   * mqttsettopic(t): set the topic of the mqtt client
@@ -1006,10 +1051,12 @@ int16_t wirereadbyte();
   */
 
  void mqttbegin();
+ void mqttloop();
+ void mqttset(uint8_t);
  void mqttsetname();
- uint8_t mqttstat(uint8_t);
+ int mqttstat(uint8_t);
  uint8_t mqttreconnect();
- uint8_t mqttstate();
+ int mqttstate();
  void mqttsubscribe(const char*);
  void mqttunsubscribe();
  void mqttsettopic(const char*);
@@ -1071,6 +1118,10 @@ int16_t wirereadbyte();
   *  ifileclose(): close a file for input
   *  ofileopen(s, m): open a file for output with mode m
   *  ofileclose(): close a file for output 
+  *  rfileopen(s): open a file for random access as input and output
+  *  fileblockread(b, n), fileblockwrite(b, n): binary block access 
+  *  ifileseek(p), ofileseek(p): position the files for record I/O
+  *  ifiletell(): the position of the input file
   * 
   * The wrapper and BASIC currently only support one file for read 
   * and one file for write.
@@ -1083,6 +1134,12 @@ int16_t wirereadbyte();
  void ifileclose();
  uint8_t ofileopen(const char*, const char*);
  void ofileclose();
+ uint8_t rfileopen(const char*);
+ uint16_t fileblockread(char*, uint16_t);
+ uint16_t fileblockwrite(char*, uint16_t);
+ uint8_t ifileseek(unsigned long);
+ uint8_t ofileseek(unsigned long);
+ unsigned long ifiletell();
  
  /*
   * Directory handling for the catalog function these methods are
@@ -1192,13 +1249,14 @@ int camerafbget(int);
  * Currently only the 23LCV512 is implemented, assuming a 64kB SRAM.
  * Part of code is taken in part from the SRAMsimple library.
  * 
- * Two buffers are implemented: 
+ * A set associative write back page cache is implemented: 
  * 
- * - a ro buffer used by memread, this buffer is mainly reading the token 
- *  stream at runtime. 
- * - a rw buffer used by memread2 and memwrite2, this buffer is mainly accessing
- *  the heap at runtime. In interactive mode this is also the interface to read 
+ * - the ro calls are used by memread, mainly reading the token stream at 
+ *  runtime. A miss on the page after the last one prefetches the next page.
+ * - the rw calls are used by memread2 and memwrite2, mainly accessing the 
+ *  heap at runtime. In interactive mode this is also the interface to read 
  *  and write program code to memory. 
+ * - spiram_rwbufferflush() writes all dirty pages back.
  * 
  */
 
@@ -1207,11 +1265,16 @@ uint16_t spirambegin();
 int8_t spiramrawread(uint16_t);
 void spiram_bufferread(uint16_t, int8_t*, uint16_t);
 void spiram_bufferwrite(uint16_t, int8_t*, uint16_t);
+void spiram_blockread(uint16_t, int8_t*, uint16_t); /* block access coherent with the cache */
+void spiram_blockwrite(uint16_t, int8_t*, uint16_t);
 int8_t spiram_robufferread(uint16_t);
 void spiram_rwbufferflush(); /* flush the buffer */
 int8_t spiram_rwbufferread(uint16_t);
 void spiram_rwbufferwrite(uint16_t, int8_t); /* the buffered file write */
 void spiramrawwrite(uint16_t, int8_t); /* the simple unbuffered byte write, with a cast to signed char */
+#ifdef SPIRAMSIMULATOR
+unsigned long spiramstat(uint8_t); /* the bus and cache counters of the simulator */
+#endif
 
 // defined RUNTIMEH
 #endif
@@ -0,0 +1,26 @@
+10 REM "MQTT loopback test, messages sent to a topic come back"
+20 REM "Needs a broker, see README.md"
+30 DIM A$(64)
+100 REM "Subscribe to the test topics and publish to one of them"
+110 OPEN &9,"iotbasic/loop/#",0
+120 OPEN &9,"iotbasic/loop/a",1
+130 PRINT "state"; NETSTAT
+200 REM "QoS 0 messages"
+210 FOR I=1 TO 5: PRINT &9,"qos0 message";I: NEXT
+220 GOSUB 800
+230 FOR I=1 TO 5: INPUT &9,A$: PRINT A$: NEXT
+300 REM "QoS 1 messages, wait until the broker has acknowledged them"
+310 SET 26,1
+320 FOR I=1 TO 3: PRINT &9,"qos1 message";I: NEXT
+330 GOSUB 800
+340 T=MILLIS(1)
+350 IF USR(9,3)>0 AND MILLIS(1)-T<2000 THEN 350
+360 PRINT "unacknowledged"; USR(9,3)
+370 FOR I=1 TO 3: INPUT &9,A$: PRINT A$: NEXT
+380 PRINT "queued"; USR(9,2)
+390 END
+800 REM "Wait for the first message to come back"
+810 T=MILLIS(1)
+820 IF AVAIL(9)=0 AND MILLIS(1)-T<2000 THEN 820
+830 DELAY 100
+840 RETURN
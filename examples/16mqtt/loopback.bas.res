@@ -0,0 +1,11 @@
+state3
+qos0 message1
+qos0 message2
+qos0 message3
+qos0 message4
+qos0 message5
+unacknowledged0
+qos1 message1
+qos1 message2
+qos1 message3
+queued0
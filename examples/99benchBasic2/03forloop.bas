@@ -0,0 +1,15 @@
+10 REM "nested empty FOR loops"
+20 N$="forloop": N=2500
+30 GOSUB 9000
+40 END
+1000 FOR I=1 TO N: FOR J=1 TO N: NEXT: NEXT
+1010 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -0,0 +1,17 @@
+10 REM "GOSUB and RETURN to a nearby subroutine"
+20 N$="gosub": N=500000
+30 GOSUB 9000
+40 END
+1000 FOR I=1 TO N: GOSUB 1100: NEXT
+1010 RETURN
+1100 A=I
+1110 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -0,0 +1,21 @@
+10 REM "building, slicing and comparing strings"
+20 N$="string": N=20000
+30 DIM A$(80), B$(80)
+40 GOSUB 9000
+50 END
+1000 FOR I=1 TO N
+1010 A$=""
+1020 FOR J=1 TO 40: A$=A$+"x": NEXT
+1030 B$=A$(11, 30)
+1040 IF A$=B$ THEN PRINT "error"
+1050 NEXT
+1060 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
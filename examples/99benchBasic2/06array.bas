@@ -0,0 +1,20 @@
+10 REM "array arithmetic, fill, scale and sum"
+20 N$="array": N=1000
+30 DIM A(N), B(N)
+40 GOSUB 9000
+50 END
+1000 FOR I=1 TO N: A(I)=I: NEXT
+1010 FOR K=1 TO 200
+1020 FOR I=1 TO N: B(I)=A(I)*1.5+B(I): NEXT
+1030 NEXT
+1040 S=0: FOR I=1 TO N: S=S+B(I): NEXT
+1050 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -0,0 +1,26 @@
+10 REM "the Mandelbrot set without output, float arithmetic"
+20 N$="mandel": N=50: R=30
+30 GOSUB 9000
+40 END
+1000 C=0
+1010 FOR J=-R TO R
+1020 FOR I=-2*R TO R
+1030 C0=I/R: C1=J/R: Z0=C0: Z1=C1
+1040 FOR K=1 TO N
+1050 S0=Z0*Z0: S1=Z1*Z1
+1060 IF S0+S1>4 THEN BREAK
+1070 Z1=2*Z0*Z1+C1: Z0=S0-S1+C0
+1080 NEXT
+1090 C=C+K
+1100 NEXT
+1110 NEXT
+1120 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -0,0 +1,22 @@
+10 REM "write and read back a file of numbers"
+20 N$="fileio": N=150000
+30 GOSUB 9000
+40 DELETE "bench.dat"
+50 END
+1000 OPEN "bench.dat", 1
+1010 FOR I=1 TO N: PRINT &16, I: NEXT
+1020 CLOSE 1
+1030 OPEN "bench.dat"
+1040 S=0
+1050 FOR I=1 TO N: INPUT &16, A: S=S+A: NEXT
+1060 CLOSE 0
+1070 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
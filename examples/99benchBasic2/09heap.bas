@@ -0,0 +1,22 @@
+10 REM "heap churn, allocate and free arrays, strings and function arguments"
+20 N$="heap": N=150000
+30 DEF FNF(X)=X*X+1
+40 GOSUB 9000
+50 END
+1000 FOR I=1 TO N
+1010 DIM H(20): H(20)=I
+1020 DIM H$(40): H$="heap"
+1030 A=FNF(I)
+1040 CLR H$
+1050 CLR H()
+1060 NEXT
+1070 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -0,0 +1,320 @@
+10 REM "GOTO and GOSUB across a long program, line search"
+20 N$="linejump": N=500000
+30 GOSUB 9000
+40 END
+1000 FOR I=1 TO N
+1010 GOSUB 8000
+1020 GOTO 7990
+1030 NEXT
+1040 RETURN
+2000 A=A+1
+2020 A=A+1
+2040 A=A+1
+2060 A=A+1
+2080 A=A+1
+2100 A=A+1
+2120 A=A+1
+2140 A=A+1
+2160 A=A+1
+2180 A=A+1
+2200 A=A+1
+2220 A=A+1
+2240 A=A+1
+2260 A=A+1
+2280 A=A+1
+2300 A=A+1
+2320 A=A+1
+2340 A=A+1
+2360 A=A+1
+2380 A=A+1
+2400 A=A+1
+2420 A=A+1
+2440 A=A+1
+2460 A=A+1
+2480 A=A+1
+2500 A=A+1
+2520 A=A+1
+2540 A=A+1
+2560 A=A+1
+2580 A=A+1
+2600 A=A+1
+2620 A=A+1
+2640 A=A+1
+2660 A=A+1
+2680 A=A+1
+2700 A=A+1
+2720 A=A+1
+2740 A=A+1
+2760 A=A+1
+2780 A=A+1
+2800 A=A+1
+2820 A=A+1
+2840 A=A+1
+2860 A=A+1
+2880 A=A+1
+2900 A=A+1
+2920 A=A+1
+2940 A=A+1
+2960 A=A+1
+2980 A=A+1
+3000 A=A+1
+3020 A=A+1
+3040 A=A+1
+3060 A=A+1
+3080 A=A+1
+3100 A=A+1
+3120 A=A+1
+3140 A=A+1
+3160 A=A+1
+3180 A=A+1
+3200 A=A+1
+3220 A=A+1
+3240 A=A+1
+3260 A=A+1
+3280 A=A+1
+3300 A=A+1
+3320 A=A+1
+3340 A=A+1
+3360 A=A+1
+3380 A=A+1
+3400 A=A+1
+3420 A=A+1
+3440 A=A+1
+3460 A=A+1
+3480 A=A+1
+3500 A=A+1
+3520 A=A+1
+3540 A=A+1
+3560 A=A+1
+3580 A=A+1
+3600 A=A+1
+3620 A=A+1
+3640 A=A+1
+3660 A=A+1
+3680 A=A+1
+3700 A=A+1
+3720 A=A+1
+3740 A=A+1
+3760 A=A+1
+3780 A=A+1
+3800 A=A+1
+3820 A=A+1
+3840 A=A+1
+3860 A=A+1
+3880 A=A+1
+3900 A=A+1
+3920 A=A+1
+3940 A=A+1
+3960 A=A+1
+3980 A=A+1
+4000 A=A+1
+4020 A=A+1
+4040 A=A+1
+4060 A=A+1
+4080 A=A+1
+4100 A=A+1
+4120 A=A+1
+4140 A=A+1
+4160 A=A+1
+4180 A=A+1
+4200 A=A+1
+4220 A=A+1
+4240 A=A+1
+4260 A=A+1
+4280 A=A+1
+4300 A=A+1
+4320 A=A+1
+4340 A=A+1
+4360 A=A+1
+4380 A=A+1
+4400 A=A+1
+4420 A=A+1
+4440 A=A+1
+4460 A=A+1
+4480 A=A+1
+4500 A=A+1
+4520 A=A+1
+4540 A=A+1
+4560 A=A+1
+4580 A=A+1
+4600 A=A+1
+4620 A=A+1
+4640 A=A+1
+4660 A=A+1
+4680 A=A+1
+4700 A=A+1
+4720 A=A+1
+4740 A=A+1
+4760 A=A+1
+4780 A=A+1
+4800 A=A+1
+4820 A=A+1
+4840 A=A+1
+4860 A=A+1
+4880 A=A+1
+4900 A=A+1
+4920 A=A+1
+4940 A=A+1
+4960 A=A+1
+4980 A=A+1
+5000 A=A+1
+5020 A=A+1
+5040 A=A+1
+5060 A=A+1
+5080 A=A+1
+5100 A=A+1
+5120 A=A+1
+5140 A=A+1
+5160 A=A+1
+5180 A=A+1
+5200 A=A+1
+5220 A=A+1
+5240 A=A+1
+5260 A=A+1
+5280 A=A+1
+5300 A=A+1
+5320 A=A+1
+5340 A=A+1
+5360 A=A+1
+5380 A=A+1
+5400 A=A+1
+5420 A=A+1
+5440 A=A+1
+5460 A=A+1
+5480 A=A+1
+5500 A=A+1
+5520 A=A+1
+5540 A=A+1
+5560 A=A+1
+5580 A=A+1
+5600 A=A+1
+5620 A=A+1
+5640 A=A+1
+5660 A=A+1
+5680 A=A+1
+5700 A=A+1
+5720 A=A+1
+5740 A=A+1
+5760 A=A+1
+5780 A=A+1
+5800 A=A+1
+5820 A=A+1
+5840 A=A+1
+5860 A=A+1
+5880 A=A+1
+5900 A=A+1
+5920 A=A+1
+5940 A=A+1
+5960 A=A+1
+5980 A=A+1
+6000 A=A+1
+6020 A=A+1
+6040 A=A+1
+6060 A=A+1
+6080 A=A+1
+6100 A=A+1
+6120 A=A+1
+6140 A=A+1
+6160 A=A+1
+6180 A=A+1
+6200 A=A+1
+6220 A=A+1
+6240 A=A+1
+6260 A=A+1
+6280 A=A+1
+6300 A=A+1
+6320 A=A+1
+6340 A=A+1
+6360 A=A+1
+6380 A=A+1
+6400 A=A+1
+6420 A=A+1
+6440 A=A+1
+6460 A=A+1
+6480 A=A+1
+6500 A=A+1
+6520 A=A+1
+6540 A=A+1
+6560 A=A+1
+6580 A=A+1
+6600 A=A+1
+6620 A=A+1
+6640 A=A+1
+6660 A=A+1
+6680 A=A+1
+6700 A=A+1
+6720 A=A+1
+6740 A=A+1
+6760 A=A+1
+6780 A=A+1
+6800 A=A+1
+6820 A=A+1
+6840 A=A+1
+6860 A=A+1
+6880 A=A+1
+6900 A=A+1
+6920 A=A+1
+6940 A=A+1
+6960 A=A+1
+6980 A=A+1
+7000 A=A+1
+7020 A=A+1
+7040 A=A+1
+7060 A=A+1
+7080 A=A+1
+7100 A=A+1
+7120 A=A+1
+7140 A=A+1
+7160 A=A+1
+7180 A=A+1
+7200 A=A+1
+7220 A=A+1
+7240 A=A+1
+7260 A=A+1
+7280 A=A+1
+7300 A=A+1
+7320 A=A+1
+7340 A=A+1
+7360 A=A+1
+7380 A=A+1
+7400 A=A+1
+7420 A=A+1
+7440 A=A+1
+7460 A=A+1
+7480 A=A+1
+7500 A=A+1
+7520 A=A+1
+7540 A=A+1
+7560 A=A+1
+7580 A=A+1
+7600 A=A+1
+7620 A=A+1
+7640 A=A+1
+7660 A=A+1
+7680 A=A+1
+7700 A=A+1
+7720 A=A+1
+7740 A=A+1
+7760 A=A+1
+7780 A=A+1
+7800 A=A+1
+7820 A=A+1
+7840 A=A+1
+7860 A=A+1
+7880 A=A+1
+7900 A=A+1
+7920 A=A+1
+7940 A=A+1
+7960 A=A+1
+7980 A=A+1
+7990 GOTO 1030
+8000 RETURN
+9000 REM "the harness, warmup and repetitions come from the command line"
+9010 BW=1: BR=5
+9020 IF LEN(@A$)>0 THEN BA$=@A$: BW=VAL(BA$): BR=VAL(BA$(INSTR(BA$, " ")))
+9030 FOR BJ=1 TO BW: GOSUB 1000: NEXT
+9040 FOR BJ=1 TO BR
+9050 BT=MILLIS(1): GOSUB 1000: BT=MILLIS(1)-BT
+9060 PRINT N$; ","; BJ; ","; BT
+9070 NEXT
+9080 RETURN
@@ -48,16 +48,16 @@ Testing indexing A(I), B() is zero
 Testing A(2)
 127  = 127
 Autodimensioning C
-1 5.74858E-6
-2 0.72782
-3 0.6201
-4 0.59269
-5 2.51519
-6 4.61416
-7 4.76449
-8 1.50486
-9 4.63455
-10 9.2524
+1 0.88685
+2 0.52791
+3 3.74249E-2
+4 2.69294
+5 0.16261
+6 3.07792
+7 0.17085
+8 2.95656
+9 5.51081
+10 0.13532
 Testing B() and @()
 Is the size of the memory array larger than zero?  -1
 1   6   6   = 6  
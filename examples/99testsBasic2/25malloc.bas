@@ -21,7 +21,7 @@
 620 PRINT "Memory address of array A() is", F
 700 A$="Hello World"
 710 F=FIND(A$)
-720 PRINT "Memory address of string A$ is", F 
+720 IF F>HIMEM THEN PRINT "String A$ is on the heap with length", PEEK(F)
 800 PRINT "HIMEM is now ", HIMEM
 810 CLR 1
 820 PRINT "HIMEM after CLR", HIMEM
@@ -19,8 +19,8 @@ Retrieving data
 14 28
 15 30
 Memory address of buffer 1 is 65519
-Memory address of variable A0 is 65488
-Memory address of array A() is 65450
-Memory address of string A$ is 65409
-HIMEM is now  65403
-HIMEM after CLR 65403
+Memory address of variable A0 is 65489
+Memory address of array A() is 65452
+String A$ is on the heap with length 11
+HIMEM is now  65405
+HIMEM after CLR 65534
@@ -1,13 +1,13 @@
 MIDNIGHT DREARY
-PROPHET BEGUILING ME
-AND MY SOUL
-     YET AGAIN 
-PROPHET THRILLED ME AND MY SOUL NEVERMORE 
-PROPHET, STILL SITTING....
-AND MY SOUL
+PROPHET BURNED DARKNESS THERE ...EVERMORE 
+THING OF EVIL NEVER FLITTING, SIGN OF PARTING SLOWLY CREEPING
+
+BIRD OR FIEND BURNED
+DARKNESS THERE YET AGAIN 
+PROPHET BEGUILING ME DARKNESS THERE
      NOTHING MORE 
-FIERY EYES THRILLED ME QUOTH THE RAVEN NEVERMORE 
 PROPHET
-     NEVER FLITTING
-QUOTH THE RAVEN SLOWLY CREEPING 
+     NEVER FLITTING,
+SHALL BE LIFTED YET AGAIN,
+
 
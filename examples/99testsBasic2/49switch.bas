@@ -33,3 +33,20 @@
 460 REM
 470 SWEND
 480 NEXT
+500 REM "Sparse, negative, fractional and repeated labels"
+510 FOR A=-3 TO 3000 STEP 0.5
+520 SWITCH A
+530 CASE 1000: PRINT A;"thousand"
+540 CASE -2, 7, 2999.5: PRINT A;"odd ones"
+550 CASE 7, 1.5: PRINT A;"not for seven"
+560 SWEND
+570 NEXT
+600 REM "A compact range with holes"
+610 FOR A=-1 TO 12
+620 SWITCH A
+630 CASE 1,2,3: PRINT A;"low"
+640 CASE 5,6,8: PRINT A;"mid"
+650 CASE 10: PRINT A;"ten"
+660 CASE 2: PRINT A;"not for two"
+670 SWEND
+680 NEXT
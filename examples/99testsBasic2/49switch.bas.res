@@ -15,3 +15,15 @@ one or two
 three
 B: no case found
 default
+-2odd ones
+1.5not for seven
+7odd ones
+1000thousand
+2999.5odd ones
+1low
+2low
+3low
+5mid
+6mid
+8mid
+10ten
@@ -1,57 +1,57 @@
 Microsoft mode
-5.74858E-6
-0.36391
-0.2067
-0.14817
-0.50303
-0.76902
-0.68064
-0.1881
-0.51495
-0.92524
+0.88685
+0.26395
+1.24749E-2
+0.67323
+3.25221E-2
+0.51298
+2.4408E-2
+0.36957
+0.61231
+1.35322E-2
 **
-0.92495
+0.38528
 **
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
-0.92495
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
+0.38528
 **
-0.18798
-0.36092
-0.2996
-0.59018
-3.52415E-2
-0.25562
-0.25857
-0.97703
-0.34959
-0.94906
+0.70972
+0.95784
+0.85144
+0.63623
+0.85534
+0.99834
+0.82554
+0.84131
+0.52536
+0.88832
 Apple mode
-4.19261
-6.97598
-7.85985
-5.72737
-0.43226
-3.75033E-2
-1.31136
-1.30647
-6.78356
-7.01431
+7.41432
+6.60078
+4.49635
+3.20203
+7.1877
+3.57628
+0.85857
+2.33725
+1.78577
+2.58309
 Palo Alto mode
-5
-2
 8
-5
-1
 1
-8
 2
 8
-4
+8
+3
+7
+3
+8
+3
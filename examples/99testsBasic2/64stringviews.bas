@@ -0,0 +1,13 @@
+5 REM substrings of substrings, LEN and ASC of string functions
+10 A$="Hello, World"
+20 PRINT MID$(LEFT$(A$,5),2,3)
+30 PRINT LEN(MID$(A$,3,4)), LEN(STR$(12345)), LEN(RIGHT$(A$,5))
+40 PRINT ASC(RIGHT$(A$,5)), ASC(CHR$(65)), ASC(MID$(A$,2))
+50 IF LEFT$(A$,5)="Hello" THEN PRINT "eq"
+60 PRINT RIGHT$(MID$(A$,1,9),3)
+70 PRINT INSTR(MID$(A$,3),"W")
+100 REM "Arrays created in the arguments move the heap under a view"
+110 B$=LEFT$(A$, C(2)+5): PRINT B$
+120 PRINT RIGHT$(MID$(A$, D(1)+1, 9), E(3)+3)
+130 K$="xW": PRINT INSTR(MID$(A$, G(1)+3), "W"), INSTR(A$, MID$(K$, J(1)+2))
+140 PRINT LEFT$(MID$(A$, H(2)+8), I(4)+3)
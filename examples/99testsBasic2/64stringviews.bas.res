@@ -0,0 +1,10 @@
+ell
+4 5 5
+87 65 101
+eq
+ Wo
+6
+Hello
+ Wo
+6 8
+Wor
@@ -0,0 +1,19 @@
+5 REM MAT applies a function to all elements of an array
+10 DIM A(20), B(20)
+20 FOR I=1 TO 20: A(I)=I/10: NEXT
+30 MAT B = SIN(A)
+40 E=0: FOR I=1 TO 20: IF B(I)<>SIN(A(I)) THEN E=E+1
+50 NEXT: PRINT "sin errors", E
+60 MAT B = EXP(A): MAT B = LOG(B)
+70 PRINT INT(B(5)*100+0.5), INT(B(20)*100+0.5)
+80 MAT A = SQR(A): PRINT A(10)
+90 DIM C(3,2): C(2,2)=-2.5: C(3,1)=7.9
+100 MAT C = ABS(C): MAT C = INT(C): PRINT C(2,2), C(3,1)
+110 DIM D(5): MAT D = COS(D): PRINT D(1), D(5)
+120 REM "SQR, ABS and INT are done in vectors and a scalar rest"
+130 DIM E(37), F(37)
+140 FOR I=1 TO 37: E(I)=(I-19)*1.37: NEXT
+150 MAT F = ABS(E): G=0: FOR I=1 TO 37: IF F(I)<>ABS(E(I)) THEN G=G+1
+160 NEXT: MAT F = INT(E): FOR I=1 TO 37: IF F(I)<>INT(E(I)) THEN G=G+1
+170 NEXT: MAT E = ABS(E): MAT F = SQR(E): FOR I=1 TO 37: IF F(I)<>SQR(E(I)) THEN G=G+1
+180 NEXT: PRINT "vector errors", G
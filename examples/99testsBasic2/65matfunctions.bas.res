@@ -0,0 +1,6 @@
+sin errors 0
+50 200
+1
+2 7
+1 1
+vector errors 0
@@ -0,0 +1,22 @@
+5 REM Statistical quality of RND and the random number streams
+10 N=10000: DIM H(10), R(1000)
+20 FOR I=1 TO N: X=RND(1): H(INT(X*10)+1)=H(INT(X*10)+1)+1: S=S+X: NEXT
+30 C=0: FOR I=1 TO 10: C=C+(H(I)-N/10)^2/(N/10): NEXT
+40 REM chi square with 9 degrees of freedom below 27.9 at 0.999
+50 IF C<27.9 THEN PRINT "chi square ok" ELSE PRINT "chi square failed", C
+60 IF ABS(S/N-0.5)<0.01 THEN PRINT "mean ok" ELSE PRINT "mean failed", S/N
+100 REM serial correlation of successive numbers
+110 Y=RND(1): T=0
+120 FOR I=1 TO N: X=Y: Y=RND(1): T=T+(X-0.5)*(Y-0.5): NEXT
+130 IF ABS(T/N*12)<0.05 THEN PRINT "correlation ok" ELSE PRINT "correlation failed", T/N*12
+200 REM streams with the same seed are reproducible and differ
+210 SET 27,1: @R=42: A=RND(1): SET 27,2: @R=42: B=RND(1)
+220 SET 27,1: @R=42: IF RND(1)=A AND A<>B THEN PRINT "streams ok" ELSE PRINT "streams failed"
+230 REM a stream selected for the first time starts with the last seed
+240 SET 27,0: @R=7: B=RND(1): SET 27,3: A=RND(1)
+250 SET 27,3: @R=7: IF RND(1)=A AND A<>B THEN PRINT "fresh stream ok" ELSE PRINT "fresh stream failed"
+300 REM MAT fills an array with random numbers
+310 MAT R = RND(6): M=0: E=0
+320 FOR I=1 TO 1000: M=M+R(I): IF R(I)<0 OR R(I)>=6 THEN E=E+1
+330 NEXT
+340 IF E=0 AND ABS(M/1000-3)<0.2 THEN PRINT "mat rnd ok" ELSE PRINT "mat rnd failed", E, M/1000
@@ -0,0 +1,6 @@
+chi square ok
+mean ok
+correlation ok
+streams ok
+fresh stream ok
+mat rnd ok
@@ -0,0 +1,34 @@
+10 REM "Binary records with GET # and PUT #"
+20 DIM A(8), B(8), S$(20)
+30 N=6
+100 PRINT "Write records in reverse order"
+105 OPEN "records.dat", 1: CLOSE 1
+110 OPEN "records.dat", 3, 64
+120 IF @S<>0 THEN PRINT "OPEN failed": END
+130 FOR R=N-1 TO 0 STEP -1
+140 FOR I=1 TO 8: A(I)=R+I/4: NEXT
+150 S$="Record "+STR$(R)
+160 PUT #R, R, R*R/2, S$, A()
+170 NEXT
+200 PRINT "Read them back randomly"
+210 FOR R=1 TO N-1 STEP 2
+220 GET #R, X, Y, T$, B()
+230 PRINT X, Y, T$, B(1), B(8)
+240 NEXT
+300 PRINT "Update a record in place"
+310 PUT #2, 42
+320 GET #2, X, Y, T$: PRINT X, Y, T$
+400 PRINT "Read past the end"
+410 @S=0: GET #N, X: PRINT X, @S
+420 CLOSE 3
+500 PRINT "Byte positions without record size"
+510 OPEN "records.dat"
+520 GET #64, X: PRINT X
+530 CLOSE
+600 PRINT "Records are limited by the record size"
+605 ERROR GOTO 700
+610 OPEN "records.dat", 3, 8
+620 PUT #0, 1, 2, 3
+700 PRINT "Error", ERROR
+710 CLOSE
+720 DELETE "records.dat"
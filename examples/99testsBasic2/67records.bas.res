@@ -0,0 +1,13 @@
+Write records in reverse order
+Read them back randomly
+1 0.5 Record 1 1.25 3
+3 4.5 Record 3 3.25 5
+5 12.5 Record 5 5.25 7
+Update a record in place
+42 2 Record 2
+Read past the end
+0 1
+Byte positions without record size
+1
+Records are limited by the record size
+Error 16
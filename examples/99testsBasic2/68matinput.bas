@@ -0,0 +1,31 @@
+10 REM "Bulk input of comma separated files with MAT INPUT"
+20 DIM A(5,3)
+30 DIM B(8)
+40 DIM S$(10,4)
+100 PRINT "Write a sensor log"
+110 OPEN "sensor.csv", 1
+120 PRINT &16, "time,temp,hum"
+130 FOR I=1 TO 4: PRINT &16, I; ","; 20+I/2; ","; 40+I: NEXT
+140 PRINT &16, "5;22.5;45"
+160 CLOSE 1
+200 PRINT "Read it into a two dimensional array"
+210 OPEN "sensor.csv"
+220 @S=0: MAT INPUT A, R, F
+230 PRINT R, F, @S
+240 FOR I=1 TO 5: PRINT A(I,1), A(I,2), A(I,3): NEXT
+250 CLOSE
+300 PRINT "Fill a one dimensional array, the rest stays in the file"
+310 OPEN "sensor.csv": INPUT &16, H$
+320 MAT INPUT B, R, F: PRINT R, F
+330 FOR I=1 TO 8: PRINT B(I);" ";: NEXT: PRINT
+340 INPUT &16, L$: PRINT L$
+350 CLOSE
+400 PRINT "Strings"
+410 OPEN "sensor.csv": MAT INPUT S$
+420 FOR I=1 TO 4: PRINT S$()(I): NEXT
+430 CLOSE
+500 PRINT "Signs"
+510 OPEN "sensor.csv", 1: PRINT &16, "+1, +2.5,-3, - 4,+": CLOSE 1
+520 OPEN "sensor.csv": MAT INPUT B, R, F: CLOSE
+530 PRINT R, F: FOR I=1 TO 5: PRINT B(I);" ";: NEXT: PRINT
+600 DELETE "sensor.csv"
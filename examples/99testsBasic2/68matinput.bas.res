@@ -0,0 +1,20 @@
+Write a sensor log
+Read it into a two dimensional array
+5 15 1
+0 0 0
+1 20.5 41
+2 21 42
+3 21.5 43
+4 22 44
+Fill a one dimensional array, the rest stays in the file
+3 8
+1 20.5 41 2 21 42 3 21.5 
+43
+Strings
+time
+temp
+hum
+1
+Signs
+1 5
+1 2.5 -3 0 0 
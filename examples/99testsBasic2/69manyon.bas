@@ -0,0 +1,21 @@
+10 REM "Many ON statements, more than the jump table cache holds"
+20 REM "Lines 1000 to 2199 are generated, every fourth is an ON"
+30 DIM A$(80)
+40 FOR I=0 TO 299
+50 L=1000+I*4
+60 IF I<280 THEN A$="ON J GOTO " ELSE A$="ON J GOSUB "
+70 A$=A$+STR$(L+1)+","+STR$(L+2)+","+STR$(L+1)+","+STR$(L+2)
+80 IF I>=280 THEN A$=A$+": GOTO "+STR$(L+3)
+90 EVAL L, A$
+100 IF I<280 THEN A$="X=X+1: GOTO "+STR$(L+3) ELSE A$="Y=Y+1: RETURN"
+110 EVAL L+1, A$
+120 IF I<280 THEN A$="X=X+2" ELSE A$="Y=Y+2: RETURN"
+130 EVAL L+2, A$
+135 EVAL L+3, "REM"
+140 NEXT
+200 X=0: Y=0
+210 FOR K=1 TO 5: J=K-INT(K/4)*4+1
+220 GOTO 1000
+2200 NEXT K
+2210 PRINT "goto", X, "gosub", Y
+2220 J=17: ON J GOTO 1,2: PRINT "out of range"
@@ -0,0 +1,2 @@
+goto 2240 gosub 160
+out of range
@@ -0,0 +1,52 @@
+10 REM "DEF FN with several parameters and LOCAL variables"
+20 DEF FNH(X,Y)=SQR(X*X+Y*Y)
+30 DEF FNV(A,B,C)=A*B*C
+40 PRINT FNH(3,4), FNV(2,3,4)
+50 REM "Missing arguments are zero, parameters hide the globals"
+60 X=7: A=1
+70 PRINT FNV(2,3), FNH(5), X, A
+100 REM "Locals hide globals and start at zero"
+110 DEF FNS(N)
+120 LOCAL I, S
+130 FOR I=1 TO N: S=S+I: NEXT
+140 RETURN S
+150 FEND
+160 I=99: S=-1
+170 PRINT FNS(10), FNS(100), I, S
+180 REM "A function does not see the arguments of its caller"
+185 DEF FNA(X)=FNP(1)+X
+190 DEF FNP(Y)=X*10+Y
+195 X=5: PRINT FNA(2)
+200 REM "Recursion, every call has its own locals"
+210 DEF FNF(N)
+220 LOCAL R
+230 IF N<2 THEN RETURN 1
+240 R=N*FNF(N-1)
+250 RETURN R
+260 FEND
+270 PRINT FNF(1), FNF(5), FNF(10)
+300 DEF FNB(N, D)
+310 LOCAL L, R
+320 IF N<2 THEN RETURN N
+330 L=FNB(N-1, D+1): R=FNB(N-2, D+1)
+340 RETURN L+R
+350 FEND
+360 PRINT FNB(15, 0), D
+400 REM "Redefine with fewer and with more names"
+410 DEF FNV(A)=A+1
+420 PRINT FNV(1)
+430 DEF FNV(A,B,C,D)=A+B+C+D
+440 PRINT FNV(1,2,3,4)
+450 REM "Redefining in a loop does not use up memory"
+460 F=0
+470 FOR K=1 TO 2000
+480 IF K%2 THEN DEF FNR(A)=A*2 ELSE DEF FNR(A,B,C,D)=A+B+C+D
+485 F=F+FNR(K)
+490 NEXT
+495 PRINT F
+500 REM "Only numbers can be local, this is an error"
+510 DEF FNL(X)
+520 LOCAL Y, A$
+530 RETURN X
+540 FEND
+550 PRINT "not reached"
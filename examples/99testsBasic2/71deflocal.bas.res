@@ -0,0 +1,10 @@
+5 24
+0 5 7 1
+55 5050 99 -1
+53
+1 120 3628800
+610 0
+2
+10
+3001000
+520: Function Error
@@ -0,0 +1,34 @@
+10 REM "The statement profiler, the counts are exact, the times are not"
+20 DIM C(200), K(10), L$(80), K$(10), N$(10)
+100 REM "Profile a fixed loop"
+110 SET 25,1
+120 FOR I=1 TO 10
+130 S=S+I
+140 IF I%2=0 THEN GOSUB 190
+150 NEXT
+160 SET 25,0
+170 GOTO 200
+190 T=T+1: RETURN
+200 PRINT S, T
+210 PROFILE "profile.txt", 20
+300 REM "Read the counts of the lines back in line order"
+310 OPEN "profile.txt"
+320 INPUT &16, L$
+330 INPUT &16, L$
+340 IF L$(1,9)="statement" THEN 400
+350 C(VAL(L$))=VAL(L$(10))
+360 GOTO 330
+400 FOR I=1 TO 200
+410 IF C(I) THEN PRINT I, C(I)
+420 NEXT
+500 REM "And the counts of the statements in a fixed order"
+510 INPUT &16, L$
+520 IF @S<>0 OR LEN(L$)=0 THEN 600
+530 K$=L$(1, INSTR(L$, " ")-1)
+540 RESTORE: FOR I=1 TO 7: READ N$: IF N$=K$ THEN K(I)=VAL(L$(10))
+550 NEXT
+560 GOTO 510
+600 RESTORE: FOR I=1 TO 7: READ N$: PRINT N$, K(I): NEXT
+610 CLOSE
+620 DELETE "profile.txt"
+700 DATA "FOR", "GOSUB", "IF", "LET", "NEXT", "RETURN", "SET"
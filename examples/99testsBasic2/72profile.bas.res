@@ -0,0 +1,14 @@
+55 5
+120 1
+130 10
+140 15
+150 10
+160 1
+190 10
+FOR 1
+GOSUB 5
+IF 10
+LET 15
+NEXT 10
+RETURN 5
+SET 1
@@ -0,0 +1,21 @@
+10 REM "The mixed integer mode, exact 64 bit integers promoted on overflow"
+20 REM "Needs a BASIC compiled with HASINT64, see 73int64.bas.cflags"
+100 PRINT "Exact sums and products"
+110 A=9223372036854775807: PRINT A, A-1
+120 B=2^62: PRINT B, B+(B-1), -B-B
+130 PRINT 123456789*987654321, 3037000499*3037000499
+140 PRINT 3^39, 10^18
+200 PRINT "Overflow promotes to floating point"
+210 PRINT A+1, B*2, -B*2-1
+220 PRINT 3^40, 4294967296*4294967296
+230 C=1: FOR I=1 TO 25: C=C*I: IF I=20 OR I=21 THEN PRINT I, C
+240 NEXT
+300 PRINT "Division and modulo"
+310 PRINT A%10, -A%10, A%-7, (A-1)/2
+320 SET 18,1: PRINT A/2, -A/2, (-A-1)/-2: SET 18,0
+330 PRINT 7/2, -7%3, 7%-3
+400 PRINT "Counting stays exact"
+410 D=9007199254740990
+420 FOR I=1 TO 5: D=D+1: PRINT D;" ";: NEXT: PRINT
+430 PRINT VAL("9223372036854775806")+1, STR$(-A-1)
+440 IF A-1=A THEN PRINT "not exact" ELSE PRINT "exact"
@@ -0,0 +1,18 @@
+Exact sums and products
+9223372036854775807 9223372036854775806
+4611686018427387904 9223372036854775807 -9223372036854775808
+121932631112635269 9223372030926249001
+4052555153018976267 1000000000000000000
+Overflow promotes to floating point
+9.22337E18 9.22337E18 -9.22337E18
+1.21576E19 1.84467E19
+20 2432902008176640000
+21 5.10909E19
+Division and modulo
+7 -7 0 4611686018427387903
+4611686018427387903 -4611686018427387903 4611686018427387904
+3.5 -1 1
+Counting stays exact
+9007199254740991 9007199254740992 9007199254740993 9007199254740994 9007199254740995 
+9223372036854775807 -9223372036854775808
+exact
@@ -0,0 +1,33 @@
+10 REM "The headless display, PRINT &2 writes to the buffer"
+20 REM "@D() reads the buffer, @X and @Y are the cursor, USR(2,1) and USR(2,2) the counters"
+30 PUT &2, 12
+40 PRINT &2, "HELLO";
+50 PRINT @X, @Y, USR(2,1), USR(2,2)
+60 R=0: GOSUB 1000
+100 REM "Scroll the screen, the last line is empty"
+110 FOR I=1 TO 30: PRINT &2, "LINE ";I: NEXT
+120 PRINT @X, @Y, USR(2,2)
+130 FOR R=0 TO 23 STEP 11: GOSUB 1000: NEXT
+200 REM "vt52 cursor addressing and movement"
+210 PUT &2, 27, "Y", 32+5, 32+10
+220 PRINT &2, "XY";
+230 PRINT @X, @Y
+240 PUT &2, 27, "A", 27, "D", 27, "D"
+250 PRINT &2, "Z";
+260 R=4: GOSUB 1000: R=5: GOSUB 1000
+270 REM "Insert a line at row 4, delete it again, clear to the end of line"
+280 PUT &2, 27, "L": PRINT &2, "NEW";
+290 FOR R=4 TO 6: GOSUB 1000: NEXT
+300 PUT &2, 27, "M"
+310 FOR R=4 TO 5: GOSUB 1000: NEXT
+320 PUT &2, 27, "Y", 32+5, 32+2, 27, "K"
+330 R=5: GOSUB 1000
+400 REM "Clear the screen"
+410 PUT &2, 12
+420 PRINT @X, @Y, @D(1), USR(2,2)
+430 END
+1000 REM "Print row R of the display"
+1010 PRINT R; ":";
+1020 FOR C=1 TO 16: D=@D(R*80+C): IF D=0 THEN D=46
+1030 PRINT CHR$(D);: NEXT: PRINT
+1040 RETURN
@@ -0,0 +1,16 @@
+5 0 5 0
+0:HELLO...........
+0 23 7
+0:LINE 8..........
+11:LINE 19.........
+22:LINE 30.........
+12 5
+4:LINE 12...Z.....
+5:LINE 13...XY....
+4:...........NEW..
+5:LINE 12...Z.....
+6:LINE 13...XY....
+4:LINE 12...Z.....
+5:LINE 13...XY....
+5:LI..............
+0 0 0 9
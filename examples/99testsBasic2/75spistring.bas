@@ -0,0 +1,10 @@
+10 REM "Long strings in the simulated SPI RAM, longer than the C buffers"
+20 DIM A$(2000), B$(2000)
+30 A$="1234"
+40 FOR I=1 TO 8: A$=A$+A$: NEXT
+50 PRINT LEN(A$), MID$(A$, 1021, 4), INSTR(A$, "41")
+60 B$=A$: IF B$=A$ THEN PRINT "equal"
+70 PRINT VAL(LEFT$(A$, 8))
+80 REM "VAL needs a C buffer, a longer string is a range error"
+90 PRINT VAL(A$)
+100 PRINT "not reached"
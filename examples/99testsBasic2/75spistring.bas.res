@@ -0,0 +1,4 @@
+1024 1234 4
+equal
+12341234
+90: Range Error
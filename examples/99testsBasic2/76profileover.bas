@@ -0,0 +1,19 @@
+10 REM "Lines after the profiler table, compiled with 4 slots"
+20 DIM L$(80)
+30 SET 25,1
+40 FOR I=1 TO 5
+50 S=S+I
+60 NEXT
+70 SET 25,0
+80 PROFILE "profile.txt"
+100 REM "Read the line counts back, the order of the lines is by time"
+110 OPEN "profile.txt"
+120 INPUT &16, L$
+130 INPUT &16, L$
+140 IF L$(1,9)="statement" THEN 200
+150 IF L$(1,5)="other" THEN O=VAL(L$(10)) ELSE C=C+VAL(L$(10))
+160 GOTO 130
+200 CLOSE
+210 DELETE "profile.txt"
+220 PRINT "table", C
+230 PRINT "other", O
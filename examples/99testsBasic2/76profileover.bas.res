@@ -0,0 +1,2 @@
+table 1
+other 11